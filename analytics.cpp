@@ -0,0 +1,203 @@
+#include "analytics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+
+#include "stats.h"
+
+namespace {
+
+constexpr int PERCENTILES[] = {10, 25, 50, 75, 90, 99};
+
+// True if student `a` ranks above student `b`. GPAs are compared exactly, as pointsA / creditsA
+// against pointsB / creditsB cross-multiplied, so equal GPAs tie whatever their doubles round to.
+// The products stay within int64 up to about 400 million hours per student.
+bool ranksAbove(const std::vector<StudentTotals>& students, const std::size_t a, const std::size_t b) {
+    const GpaTotals& totalsA = students[a].totals;
+    const GpaTotals& totalsB = students[b].totals;
+    // A student without hours has a GPA of 0, i.e. 0 points over 1 hour.
+    const std::int64_t creditsA = std::max(totalsA.credits, 1);
+    const std::int64_t creditsB = std::max(totalsB.credits, 1);
+    const std::int64_t weightedA = totalsA.pointTenths * creditsB;
+    const std::int64_t weightedB = totalsB.pointTenths * creditsA;
+    if (weightedA != weightedB) return weightedA > weightedB;
+    if (totalsA.credits != totalsB.credits) {
+        return totalsA.credits > totalsB.credits;
+    }
+    return a < b;
+}
+
+// Mean grade points of a course, in thousandths, rounded half up. Only grades on the scheme's
+// scale are ever counted.
+std::int64_t meanThousandths(const GradeCounts& counts, const GradingScheme scheme) {
+    std::int64_t tenths = 0;
+    std::int64_t grades = 0;
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        if (counts[code] == 0) continue;
+        tenths += static_cast<std::int64_t>(counts[code]) * gradeTenths(static_cast<Grade>(code), scheme);
+        grades += static_cast<std::int64_t>(counts[code]);
+    }
+    return grades == 0 ? 0 : (tenths * 200 + grades) / (2 * grades);
+}
+
+void writeShare(std::ostream& out, const std::uint64_t part, const std::uint64_t whole) {
+    out << std::fixed << std::setprecision(1)
+        << (whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole)) << '%';
+}
+
+} // namespace
+
+void GpaHistogram::add(const std::int64_t thousandths) {
+    ++counts_[std::clamp<std::int64_t>(thousandths, 0, MAX_GPA_THOUSANDTHS)];
+    ++count_;
+}
+
+int GpaHistogram::percentile(const int percent) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const std::uint64_t rank = std::max<std::uint64_t>(1, (count_ * percent + 99) / 100);
+    std::uint64_t seen = 0;
+    for (int thousandths = 0; thousandths < MAX_GPA_THOUSANDTHS; ++thousandths) {
+        seen += counts_[thousandths];
+        if (seen >= rank) {
+            return thousandths;
+        }
+    }
+    return MAX_GPA_THOUSANDTHS;
+}
+
+std::vector<std::size_t> topStudents(const std::vector<StudentTotals>& students, const std::size_t count) {
+    // The heap keeps the best `count` students so far with the weakest on top, ready to be evicted.
+    const auto weaker = [&](const std::size_t a, const std::size_t b) { return ranksAbove(students, a, b); };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(weaker)> best(weaker);
+    if (count == 0) {
+        return {};
+    }
+    for (std::size_t i = 0; i < students.size(); ++i) {
+        if (students[i].totals.credits <= 0) continue;
+        if (best.size() < count) {
+            best.push(i);
+        } else if (ranksAbove(students, i, best.top())) {
+            best.pop();
+            best.push(i);
+        }
+    }
+    std::vector<std::size_t> ranked(best.size());
+    for (auto it = ranked.rbegin(); it != ranked.rend(); ++it) {
+        *it = best.top();
+        best.pop();
+    }
+    return ranked;
+}
+
+int runAnalytics(const std::string& rosterFile, const std::string& outputFile, const unsigned threads,
+                 const std::size_t top, const GradingScheme scheme) {
+    const ScopedTimer timer(StatTimer::Analytics);
+    RosterTotals roster;
+    if (!roster.load(rosterFile, threads, true, scheme)) {
+        return 1;
+    }
+
+    GpaHistogram histogram;
+    GpaTotals cohort;
+    double gpaSum = 0.0;
+    for (const auto& student : roster.students()) {
+        cohort.add(student.totals);
+        if (student.totals.credits > 0) {
+            histogram.add(student.totals.gpaThousandths());
+            gpaSum += student.totals.gpa();
+        }
+    }
+    GradeCounts grades {};
+    std::uint64_t gradeCount = 0;
+    for (const auto& course : roster.courses()) {
+        for (int code = 0; code < GRADE_COUNT; ++code) {
+            grades[code] += course.counts[code];
+            gradeCount += course.counts[code];
+        }
+    }
+
+    std::ofstream outFile;
+    const bool toStdout = outputFile.empty() || outputFile == "-";
+    if (!toStdout) {
+        outFile.open(outputFile, std::ios::binary);
+        if (!outFile.is_open()) {
+            std::cerr << "Error: Could not open file for saving: " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = toStdout ? std::cout : outFile;
+
+    const std::size_t ungraded = roster.students().size() - histogram.count();
+    out << "Students: " << roster.students().size() << " (" << roster.rows() << " course rows";
+    if (ungraded > 0) {
+        out << ", " << ungraded << " without graded hours";
+    }
+    out << ")\n";
+    out << "Cohort GPA: ";
+    writeGpa(out, cohort.gpaThousandths());
+    out << " over " << cohort.credits << " hours\n";
+    out << "Mean student GPA: " << std::fixed << std::setprecision(3)
+        << (histogram.count() == 0 ? 0.0 : gpaSum / static_cast<double>(histogram.count())) << "\n";
+    out << "GPA percentiles:";
+    for (const int percent : PERCENTILES) {
+        out << " P" << percent << ' ';
+        writeGpa(out, histogram.percentile(percent));
+    }
+    out << "\n";
+
+    const auto ranked = topStudents(roster.students(), top);
+    if (!ranked.empty()) {
+        out << "\nTop " << ranked.size() << " students:\n";
+        for (std::size_t rank = 0; rank < ranked.size(); ++rank) {
+            const auto& student = roster.students()[ranked[rank]];
+            out << std::setw(4) << rank + 1 << ". " << student.id << "  ";
+            writeGpa(out, student.totals.gpaThousandths());
+            out << "  (" << student.totals.credits << " hours)\n";
+        }
+    }
+
+    out << "\nGrade distribution:\n";
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        if (!onScale(static_cast<Grade>(code), scheme)) continue;
+        out << "  " << std::left << std::setw(3) << GRADE_MAP[code] << std::right << std::setw(12) << grades[code]
+            << std::setw(8);
+        writeShare(out, grades[code], gradeCount);
+        out << "\n";
+    }
+
+    // The course name goes last, where the commas it may contain can't shift the other columns.
+    out << "\nCourses (grades,mean points";
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        if (onScale(static_cast<Grade>(code), scheme)) {
+            out << ',' << GRADE_MAP[code];
+        }
+    }
+    out << ",course):\n";
+    for (const auto& course : roster.courses()) {
+        std::uint64_t courseGrades = 0;
+        for (const auto count : course.counts) {
+            courseGrades += count;
+        }
+        out << courseGrades << ',';
+        writeGpa(out, meanThousandths(course.counts, scheme));
+        for (int code = 0; code < GRADE_COUNT; ++code) {
+            if (onScale(static_cast<Grade>(code), scheme)) {
+                out << ',' << course.counts[code];
+            }
+        }
+        out << ',' << course.name << '\n';
+    }
+    out.flush();
+
+    std::cerr << "Analyzed " << roster.rows() << " course rows for " << roster.students().size() << " students";
+    if (roster.rejected() > 0) {
+        std::cerr << " (" << roster.rejected() << " malformed lines skipped)";
+    }
+    std::cerr << ".\n";
+    return out ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#ifndef GPA_CALC_ANALYTICS_H
+#define GPA_CALC_ANALYTICS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "roster.h"
+
+// Highest GPA on any grading scheme, in thousandths of a point.
+inline constexpr int MAX_GPA_THOUSANDTHS = [] {
+    std::int32_t tenths = 0;
+    for (const auto& scale : GRADE_SCALES) {
+        tenths = std::max(tenths, *std::max_element(scale.tenths.begin(), scale.tenths.end()));
+    }
+    return tenths * 100;
+}();
+
+// Distribution of student GPAs at the precision they are printed with: one counter for every
+// thousandth of a point up to the best GPA of any scheme. Memory is fixed however many students
+// are added, and percentiles are exact at that precision without sorting anything.
+class GpaHistogram {
+public:
+    void add(std::int64_t thousandths);
+    std::uint64_t count() const { return count_; }
+    // Nearest-rank percentile in thousandths: the lowest GPA that at least `percent`% of the
+    // students are at or below. Zero if the histogram is empty.
+    int percentile(int percent) const;
+
+private:
+    std::array<std::uint64_t, MAX_GPA_THOUSANDTHS + 1> counts_ {};
+    std::uint64_t count_ = 0;
+};
+
+// Indices of the `count` students with the highest GPA, best first, picked with a bounded heap in
+// one pass over the students. Ties go to the student with more hours, then to the one seen first.
+// Students without graded hours have no GPA and are never ranked.
+std::vector<std::size_t> topStudents(const std::vector<StudentTotals>& students, std::size_t count);
+
+// Reads a roster like runBatch() and writes a faculty-wide report: cohort and mean GPA, GPA
+// percentiles, the top `top` students, and the distribution of the scheme's grades overall and
+// per course. The roster is parsed once; besides one entry per student and course, everything it keeps has a
+// fixed size. An empty or "-" output path writes to standard output. Returns a process exit code.
+int runAnalytics(const std::string& rosterFile, const std::string& outputFile, unsigned threads = 0,
+                 std::size_t top = 10, GradingScheme scheme = GradingScheme::Fcai);
+
+#endif //GPA_CALC_ANALYTICS_H
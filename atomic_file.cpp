@@ -0,0 +1,175 @@
+#include "atomic_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define GPA_CALC_HAVE_POSIX_IO 1
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace {
+
+#ifdef GPA_CALC_HAVE_POSIX_IO
+#ifdef IOV_MAX
+constexpr std::size_t MAX_PIECES = IOV_MAX;
+#else
+constexpr std::size_t MAX_PIECES = 1024;
+#endif
+
+// Makes a rename in the file's directory durable.
+void syncDirectory(const std::string& filename) {
+    const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+#endif
+
+} // namespace
+
+AtomicFile::~AtomicFile() {
+    discard();
+}
+
+bool AtomicFile::open(const std::string& filename) {
+    discard();
+    filename_ = filename;
+    tempName_ = filename + ".tmp";
+    size_ = 0;
+    failed_ = false;
+#ifdef GPA_CALC_HAVE_POSIX_IO
+    fd_ = ::open(tempName_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    // Keep the permissions of the file being replaced.
+    struct stat info {};
+    if (::stat(filename.c_str(), &info) == 0) {
+        ::fchmod(fd_, info.st_mode & 07777);
+    }
+    return true;
+#else
+    file_ = std::fopen(tempName_.c_str(), "wb");
+    return file_ != nullptr;
+#endif
+}
+
+bool AtomicFile::write(const std::vector<std::string_view>& pieces) {
+#ifdef GPA_CALC_HAVE_POSIX_IO
+    if (fd_ < 0 || failed_) {
+        return false;
+    }
+    std::vector<iovec> vectors;
+    vectors.reserve(std::min(pieces.size(), MAX_PIECES));
+    std::size_t next = 0;
+    while (next < pieces.size() || !vectors.empty()) {
+        while (next < pieces.size() && vectors.size() < MAX_PIECES) {
+            if (!pieces[next].empty()) {
+                vectors.push_back({const_cast<char*>(pieces[next].data()), pieces[next].size()});
+            }
+            ++next;
+        }
+        if (vectors.empty()) {
+            break;
+        }
+        const ssize_t written = ::writev(fd_, vectors.data(), static_cast<int>(vectors.size()));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            failed_ = true;
+            return false;
+        }
+        size_ += static_cast<std::size_t>(written);
+        // Drop what was written, and resume a partly written piece where it stopped.
+        auto remaining = static_cast<std::size_t>(written);
+        auto done = vectors.begin();
+        while (done != vectors.end() && remaining >= done->iov_len) {
+            remaining -= done->iov_len;
+            ++done;
+        }
+        vectors.erase(vectors.begin(), done);
+        if (!vectors.empty()) {
+            vectors.front().iov_base = static_cast<char*>(vectors.front().iov_base) + remaining;
+            vectors.front().iov_len -= remaining;
+        }
+    }
+    return true;
+#else
+    if (!file_ || failed_) {
+        return false;
+    }
+    for (const std::string_view piece : pieces) {
+        if (std::fwrite(piece.data(), 1, piece.size(), file_) != piece.size()) {
+            failed_ = true;
+            return false;
+        }
+        size_ += piece.size();
+    }
+    return true;
+#endif
+}
+
+bool AtomicFile::commit() {
+#ifdef GPA_CALC_HAVE_POSIX_IO
+    if (fd_ < 0 || failed_ || ::fsync(fd_) != 0) {
+        discard();
+        return false;
+    }
+    const bool closed = ::close(fd_) == 0;
+    fd_ = -1;
+    if (!closed || ::rename(tempName_.c_str(), filename_.c_str()) != 0) {
+        discard();
+        return false;
+    }
+    syncDirectory(filename_);
+#else
+    if (!file_ || failed_ || std::fflush(file_) != 0) {
+        discard();
+        return false;
+    }
+#ifdef _WIN32
+    _commit(_fileno(file_));
+#endif
+    const bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    std::error_code error;
+    if (closed) {
+        std::filesystem::rename(tempName_, filename_, error);
+    }
+    if (!closed || error) {
+        discard();
+        return false;
+    }
+#endif
+    tempName_.clear();
+    return true;
+}
+
+void AtomicFile::discard() {
+#ifdef GPA_CALC_HAVE_POSIX_IO
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#else
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+#endif
+    if (!tempName_.empty()) {
+        std::error_code error;
+        std::filesystem::remove(tempName_, error);
+        tempName_.clear();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef GPA_CALC_ATOMIC_FILE_H
+#define GPA_CALC_ATOMIC_FILE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replaces a file as a whole. Everything is written to "<filename>.tmp", and commit() flushes it
+// to the disk and renames it over the target, so a crash at any point leaves either the old file
+// or the complete new one, never a torn mix. An AtomicFile destroyed without a successful commit()
+// removes its temp file and leaves the target alone.
+//
+// On POSIX systems write() hands all its pieces to the kernel with vectored writes, so buffers
+// formatted separately don't have to be joined first, and the directory is synced after the
+// rename so the new name is durable too.
+class AtomicFile {
+public:
+    AtomicFile() = default;
+    ~AtomicFile();
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    bool open(const std::string& filename);
+    // Appends the pieces, in order. Returns false (and fails the commit) on a write error.
+    bool write(const std::vector<std::string_view>& pieces);
+    bool write(std::string_view data) { return write(std::vector<std::string_view>{data}); }
+    bool commit();
+
+    // Bytes written so far.
+    std::size_t size() const { return size_; }
+
+private:
+    void discard();
+
+    std::string filename_;
+    std::string tempName_;
+#if defined(__unix__) || defined(__APPLE__)
+    int fd_ = -1;
+#else
+    std::FILE* file_ = nullptr;
+#endif
+    std::size_t size_ = 0;
+    bool failed_ = false;
+};
+
+#endif //GPA_CALC_ATOMIC_FILE_H
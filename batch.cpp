@@ -0,0 +1,46 @@
+#include "batch.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "roster.h"
+#include "stats.h"
+#include "text_reader.h"
+
+int runBatch(const std::string& rosterFile, const std::string& outputFile, const unsigned threads,
+             const GradingScheme scheme) {
+    const ScopedTimer timer(StatTimer::Batch);
+    RosterTotals roster;
+    if (!roster.load(rosterFile, threads, false, scheme)) {
+        return 1;
+    }
+
+    std::vector<char> outBuffer(IO_BUFFER_SIZE);
+    std::ofstream outFile;
+    const bool toStdout = outputFile.empty() || outputFile == "-";
+    if (!toStdout) {
+        outFile.rdbuf()->pubsetbuf(outBuffer.data(), static_cast<std::streamsize>(outBuffer.size()));
+        outFile.open(outputFile, std::ios::binary);
+        if (!outFile.is_open()) {
+            std::cerr << "Error: Could not open file for saving: " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = toStdout ? std::cout : outFile;
+
+    out << "student,gpa,hours\n";
+    for (const auto& student : roster.students()) {
+        out << student.id << ',';
+        writeGpa(out, student.totals.gpaThousandths());
+        out << ',' << student.totals.credits << '\n';
+    }
+    out.flush();
+
+    std::cerr << "Processed " << roster.rows() << " course rows for " << roster.students().size() << " students";
+    if (roster.rejected() > 0) {
+        std::cerr << " (" << roster.rejected() << " malformed lines skipped)";
+    }
+    std::cerr << ".\n";
+    return out ? 0 : 1;
+}
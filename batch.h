@@ -0,0 +1,18 @@
+#ifndef GPA_CALC_BATCH_H
+#define GPA_CALC_BATCH_H
+
+#include <string>
+
+#include "grading.h"
+
+// Reads a roster with one "student,course name,credits,grade" row per line and writes
+// "student,gpa,hours" for every student, in the order students first appear. Grades are worth
+// their points on `scheme`'s scale; other letters make a line malformed.
+// The roster is split into chunks at line boundaries that are parsed and aggregated on a
+// work-stealing pool of `threads` workers (zero means one per hardware thread); the output does
+// not depend on the thread count. An empty or "-" output path writes to standard output.
+// Returns a process exit code.
+int runBatch(const std::string& rosterFile, const std::string& outputFile, unsigned threads = 0,
+             GradingScheme scheme = GradingScheme::Fcai);
+
+#endif //GPA_CALC_BATCH_H
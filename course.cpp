@@ -0,0 +1,24 @@
+#include "course.h"
+
+#include <numeric>
+
+#include "stats.h"
+
+std::string courseNameOrDefault(std::string name, int& unnamedCounter) {
+    if (name == "0" || name.empty()) {
+        return "Unnamed Course " + std::to_string(++unnamedCounter);
+    }
+    return name;
+}
+
+double allAttemptsGPA(const std::vector<Course>& courses, const GradingScheme scheme) {
+    const ScopedTimer timer(StatTimer::CalculateGPA);
+    return withScheme(scheme, [&](auto fixed) { return allAttemptsGPA<decltype(fixed)::value>(courses); });
+}
+
+int allAttemptsHours(const std::vector<Course>& courses) {
+    return std::accumulate(courses.begin(), courses.end(), 0,
+        [](const int sum, const Course& course) {
+            return sum + course.credits;
+        });
+}
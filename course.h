@@ -0,0 +1,97 @@
+#ifndef GPA_CALC_COURSE_H
+#define GPA_CALC_COURSE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "grading.h"
+
+// Credit hours accepted for a course entered by the user.
+inline constexpr int MAX_CREDITS = 9;
+
+constexpr bool validCredits(const int credits) {
+    return credits >= 0 && credits <= MAX_CREDITS;
+}
+
+// Terms (semesters) are numbered from 1 in the order they were taken. Courses from data files
+// written before terms existed are in term 1.
+inline constexpr int MAX_TERM = 99;
+
+constexpr bool validTerm(const int term) {
+    return term >= 1 && term <= MAX_TERM;
+}
+
+struct Course {
+    std::string name;
+    int credits;
+    Grade grade;
+    int term = 1;
+};
+
+// Non-owning view of a course record, e.g. one handed out by a streaming reader.
+struct CourseView {
+    std::string_view name;
+    int credits;
+    Grade grade;
+    int term = 1;
+};
+
+// Running weighted sums for one student, used where keeping every Course around is too costly.
+// The points are kept in tenths, as an exact integer: totals come out bit for bit the same
+// whatever order courses are added, removed or merged in, and removing a course leaves no
+// rounding behind.
+struct GpaTotals {
+    std::int64_t pointTenths = 0;
+    int credits = 0;
+
+    // Negative credits take a course away again. The grade must be on the scheme's scale.
+    void add(const int courseCredits, const Grade grade, const GradingScheme scheme = GradingScheme::Fcai) {
+        pointTenths += static_cast<std::int64_t>(courseCredits) * gradeTenths(grade, scheme);
+        credits += courseCredits;
+    }
+    // The same with the scheme fixed at compile time, for loops over many courses.
+    template <GradingScheme Scheme>
+    void add(const int courseCredits, const Grade grade) {
+        pointTenths += static_cast<std::int64_t>(courseCredits) * gradeTenths<Scheme>(grade);
+        credits += courseCredits;
+    }
+    void add(const GpaTotals& other) {
+        pointTenths += other.pointTenths;
+        credits += other.credits;
+    }
+
+    // One correctly rounded division of two exact integers.
+    double gpa() const {
+        return credits == 0 ? 0.0 : static_cast<double>(pointTenths) / (10.0 * credits);
+    }
+
+    // The GPA in thousandths of a point, rounded half up from the exact totals rather than from
+    // a double, so a GPA such as 2.3625 always comes out as 2363. Credits must not be negative.
+    std::int64_t gpaThousandths() const {
+        return credits == 0 ? 0 : (pointTenths * 200 + credits) / (2 * static_cast<std::int64_t>(credits));
+    }
+
+    bool operator==(const GpaTotals&) const = default;
+};
+
+// Returns `name`, or the next "Unnamed Course N" if the user left it blank (or entered "0").
+std::string courseNameOrDefault(std::string name, int& unnamedCounter);
+
+// GPA and credits over every row, so a retaken course counts once per attempt; the retake rule
+// needs a CourseBook (calculateGPA()) or LatestAttempts.
+template <GradingScheme Scheme>
+double allAttemptsGPA(const std::vector<Course>& courses) {
+    GpaTotals totals;
+    for (const auto& course : courses) {
+        totals.add<Scheme>(course.credits, course.grade);
+    }
+    return totals.gpa();
+}
+
+// Dispatches to the allAttemptsGPA() instantiation for `scheme`.
+double allAttemptsGPA(const std::vector<Course>& courses, GradingScheme scheme = GradingScheme::Fcai);
+int allAttemptsHours(const std::vector<Course>& courses);
+
+#endif //GPA_CALC_COURSE_H
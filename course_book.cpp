@@ -0,0 +1,430 @@
+#include "course_book.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+namespace {
+
+std::size_t lowestBit(const std::size_t index) {
+    return index & (~index + 1);
+}
+
+} // namespace
+
+CourseBook::CourseBook(const std::vector<Course>& courses) {
+    reserve(courses.size());
+    for (const auto& course : courses) {
+        add(course);
+    }
+}
+
+void CourseBook::add(const CourseView& course) {
+    if (slots_.size() == NO_SLOT) {
+        throw std::length_error("CourseBook: too many courses");
+    }
+    if (!validCredits(course.credits)) {
+        throw std::out_of_range("CourseBook: invalid credits");
+    }
+    if (!validTerm(course.term)) {
+        throw std::out_of_range("CourseBook: invalid term");
+    }
+    if (!onScale(course.grade, scheme_)) {
+        throw std::out_of_range("CourseBook: grade not on the grading scale");
+    }
+    totals_.add(course.credits, course.grade, scheme_);
+    terms_.addCourse(course.term, course.credits, course.grade, scheme_);
+
+    const StringPool::Id name = internName(course.name);
+    appendSlot({name, NO_SLOT, NO_SLOT, static_cast<std::uint8_t>(course.credits), course.grade,
+                static_cast<std::uint8_t>(course.term)});
+    const auto slot = static_cast<std::uint32_t>(slots_.size() - 1);
+    linkAttempt(slot);
+    countLinked(slot, 1);
+    checkTotals();
+}
+
+void CourseBook::replace(const std::size_t position, const CourseView& course) {
+    if (!validCredits(course.credits)) {
+        throw std::out_of_range("CourseBook: invalid credits");
+    }
+    if (!validTerm(course.term)) {
+        throw std::out_of_range("CourseBook: invalid term");
+    }
+    if (!onScale(course.grade, scheme_)) {
+        throw std::out_of_range("CourseBook: grade not on the grading scale");
+    }
+    const auto slot = static_cast<std::uint32_t>(slotOf(position));
+    const StringPool::Id name = internName(course.name);
+    Slot& old = slots_[slot];
+    totals_.add(-old.credits, old.grade, scheme_);
+    totals_.add(course.credits, course.grade, scheme_);
+    terms_.removeCourse(old.term, old.credits, old.grade, scheme_);
+    terms_.addCourse(course.term, course.credits, course.grade, scheme_);
+
+    // Only a new term or name moves the course to another place in attempt order.
+    const bool moves = name != old.name || course.term != old.term;
+    countLinked(slot, -1);
+    if (moves) {
+        unlinkAttempt(slot);
+    }
+    old.name = name;
+    old.credits = static_cast<std::uint8_t>(course.credits);
+    old.grade = course.grade;
+    old.term = static_cast<std::uint8_t>(course.term);
+    if (moves) {
+        linkAttempt(slot);
+    }
+    countLinked(slot, 1);
+    checkTotals();
+}
+
+void CourseBook::remove(const std::size_t position) {
+    const std::size_t slot = slotOf(position);
+    const Slot& old = slots_[slot];
+    totals_.add(-old.credits, old.grade, scheme_);
+    terms_.removeCourse(old.term, old.credits, old.grade, scheme_);
+
+    countLinked(static_cast<std::uint32_t>(slot), -1);
+    unlinkAttempt(static_cast<std::uint32_t>(slot));
+    for (std::size_t i = slot + 1; i < liveTree_.size(); i += lowestBit(i)) {
+        --liveTree_[i];
+    }
+    removed_[slot] = true;
+    ++tombstones_;
+
+    if (tombstones_ > size()) {
+        compact();
+    }
+    checkTotals();
+}
+
+void CourseBook::reserve(const std::size_t courseCount) {
+    slots_.reserve(courseCount);
+    removed_.reserve(courseCount);
+    liveTree_.reserve(courseCount + 1);
+}
+
+bool CourseBook::setScheme(const GradingScheme scheme) {
+    if (scheme == scheme_) {
+        return true;
+    }
+    compact();
+    for (const auto& slot : slots_) {
+        if (!onScale(slot.grade, scheme)) {
+            return false;
+        }
+    }
+    scheme_ = scheme;
+    totals_ = {};
+    terms_ = {};
+    for (const auto& slot : slots_) {
+        totals_.add(slot.credits, slot.grade, scheme_);
+        terms_.addCourse(slot.term, slot.credits, slot.grade, scheme_);
+    }
+    for (const auto& chain : nameChains_) {
+        std::uint32_t previous = NO_SLOT;
+        for (std::uint32_t slot = chain.first; slot != NO_SLOT; slot = slots_[slot].nextWithName) {
+            countAttempt(slot, previous, 1);
+            previous = slot;
+        }
+    }
+    checkTotals();
+    return true;
+}
+
+std::vector<std::size_t> CourseBook::findByName(const std::string_view name) const {
+    std::vector<std::size_t> positions;
+    if (const auto id = names_.find(name)) {
+        for (std::uint32_t slot = nameChains_[*id].first; slot != NO_SLOT; slot = slots_[slot].nextWithName) {
+            positions.push_back(positionOf(slot));
+        }
+    }
+    // Chains are in attempt order.
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+std::vector<std::size_t> CourseBook::findByPrefix(const std::string_view prefix, const std::size_t limit) const {
+    const auto byName = [this](const StringPool::Id a, const StringPool::Id b) { return names_[a] < names_[b]; };
+    if (sortedNames_.size() < names_.size()) {
+        const std::size_t sorted = sortedNames_.size();
+        for (auto id = static_cast<StringPool::Id>(sorted); id < names_.size(); ++id) {
+            sortedNames_.push_back(id);
+        }
+        std::sort(sortedNames_.begin() + static_cast<std::ptrdiff_t>(sorted), sortedNames_.end(), byName);
+        std::inplace_merge(sortedNames_.begin(), sortedNames_.begin() + static_cast<std::ptrdiff_t>(sorted),
+                           sortedNames_.end(), byName);
+    }
+
+    std::vector<std::size_t> positions;
+    auto it = std::partition_point(sortedNames_.begin(), sortedNames_.end(),
+                                   [&](const StringPool::Id id) { return names_[id] < prefix; });
+    for (; it != sortedNames_.end() && names_[*it].starts_with(prefix) && positions.size() < limit; ++it) {
+        const std::size_t group = positions.size();
+        for (std::uint32_t slot = nameChains_[*it].first; slot != NO_SLOT; slot = slots_[slot].nextWithName) {
+            positions.push_back(positionOf(slot));
+        }
+        // Chains are in attempt order; each name's courses are listed in list order.
+        std::sort(positions.begin() + static_cast<std::ptrdiff_t>(group), positions.end());
+    }
+    positions.resize(std::min(positions.size(), limit));
+    return positions;
+}
+
+std::size_t CourseBook::slotOf(const std::size_t position) const {
+    if (tombstones_ == 0) {
+        return position;
+    }
+    // Walk down the Fenwick tree to the slot holding the (position + 1)-th live course.
+    std::size_t slot = 0;
+    std::size_t remaining = position + 1;
+    for (std::size_t step = std::bit_floor(liveTree_.size() - 1); step > 0; step >>= 1) {
+        if (slot + step < liveTree_.size() && liveTree_[slot + step] < remaining) {
+            slot += step;
+            remaining -= liveTree_[slot];
+        }
+    }
+    return slot;
+}
+
+std::size_t CourseBook::positionOf(const std::size_t slot) const {
+    if (tombstones_ == 0) {
+        return slot;
+    }
+    std::size_t live = 0;
+    for (std::size_t i = slot; i > 0; i -= lowestBit(i)) {
+        live += liveTree_[i];
+    }
+    return live;
+}
+
+StringPool::Id CourseBook::internName(const std::string_view name) {
+    const StringPool::Id id = names_.intern(name);
+    if (id == nameChains_.size()) {
+        nameChains_.push_back({NO_SLOT, NO_SLOT, {}});
+    }
+    return id;
+}
+
+void CourseBook::appendSlot(const Slot& slot) {
+    const std::size_t index = slots_.size();
+    slots_.push_back(slot);
+    removed_.push_back(false);
+
+    // Node i of the tree covers slots (i - lowestBit(i), i]; sum the nodes below it plus this slot.
+    if (liveTree_.empty()) {
+        liveTree_.push_back(0);
+    }
+    const std::size_t node = index + 1;
+    std::uint32_t live = 1;
+    for (std::size_t child = node - 1; child > node - lowestBit(node); child -= lowestBit(child)) {
+        live += liveTree_[child];
+    }
+    liveTree_.push_back(live);
+}
+
+// Whether `slot` is a later attempt at its course than `than`: a later term, or the same term and
+// later in the list.
+bool CourseBook::laterAttempt(const std::uint32_t slot, const std::uint32_t than) const {
+    return than == NO_SLOT || slots_[slot].term > slots_[than].term ||
+           (slots_[slot].term == slots_[than].term && slot > than);
+}
+
+// Inserts a slot into its name's chain, in attempt order. Its term's tail, or the tail of the
+// latest earlier term, is the place to start; within its term it goes after the attempts earlier
+// in the list.
+void CourseBook::linkAttempt(const std::uint32_t slot) {
+    NameChain& chain = nameChains_[slots_[slot].name];
+    const std::uint8_t term = slots_[slot].term;
+    auto& tails = chain.termTails;
+    const auto tail = std::lower_bound(tails.begin(), tails.end(), term,
+                                       [](const TermTail& tail, const std::uint8_t term) { return tail.term < term; });
+    std::uint32_t previous = NO_SLOT;
+    if (tail != tails.end() && tail->term == term) {
+        previous = tail->slot;
+        if (laterAttempt(slot, previous)) {
+            tail->slot = slot;
+        }
+    } else {
+        if (tail != tails.begin()) {
+            previous = std::prev(tail)->slot;
+        }
+        tails.insert(tail, {term, slot});
+    }
+    while (previous != NO_SLOT && laterAttempt(previous, slot)) {
+        previous = slots_[previous].previousWithName;
+    }
+
+    const std::uint32_t next = previous == NO_SLOT ? chain.first : slots_[previous].nextWithName;
+    slots_[slot].previousWithName = previous;
+    slots_[slot].nextWithName = next;
+    (previous == NO_SLOT ? chain.first : slots_[previous].nextWithName) = slot;
+    (next == NO_SLOT ? chain.last : slots_[next].previousWithName) = slot;
+}
+
+// Takes a slot out of its name's chain, handing its term's tail to the attempt before it.
+void CourseBook::unlinkAttempt(const std::uint32_t slot) {
+    NameChain& chain = nameChains_[slots_[slot].name];
+    const std::uint32_t previous = slots_[slot].previousWithName;
+    const std::uint32_t next = slots_[slot].nextWithName;
+    (previous == NO_SLOT ? chain.first : slots_[previous].nextWithName) = next;
+    (next == NO_SLOT ? chain.last : slots_[next].previousWithName) = previous;
+
+    const std::uint8_t term = slots_[slot].term;
+    if (next == NO_SLOT || slots_[next].term != term) {
+        auto& tails = chain.termTails;
+        const auto tail = std::lower_bound(tails.begin(), tails.end(), term,
+                                           [](const TermTail& tail, const std::uint8_t term) { return tail.term < term; });
+        if (previous != NO_SLOT && slots_[previous].term == term) {
+            tail->slot = previous;
+        } else {
+            tails.erase(tail);
+        }
+    }
+}
+
+// Adds (sign 1) or takes away (sign -1) what a linked attempt contributes to the cumulative
+// totals, including how it changes what the attempt after it replaces.
+void CourseBook::countLinked(const std::uint32_t slot, const int sign) {
+    const std::uint32_t previous = slots_[slot].previousWithName;
+    const std::uint32_t next = slots_[slot].nextWithName;
+    countAttempt(slot, previous, sign);
+    if (next != NO_SLOT) {
+        if (sign > 0) {
+            countReplaced(next, previous, slot);
+        } else {
+            countReplaced(next, slot, previous);
+        }
+    }
+}
+
+// Adds (sign 1) or takes away (sign -1) what one attempt contributes to the cumulative totals:
+// its own points, less those of the attempt it replaces.
+void CourseBook::countAttempt(const std::uint32_t slot, const std::uint32_t previous, const int sign) {
+    const Slot& attempt = slots_[slot];
+    GpaTotals change;
+    change.add(sign * attempt.credits, attempt.grade, scheme_);
+    if (previous != NO_SLOT) {
+        change.add(-sign * slots_[previous].credits, slots_[previous].grade, scheme_);
+    }
+    terms_.addCumulative(attempt.term, change);
+}
+
+// Moves what `slot` takes away from the cumulative totals from attempt `from` to attempt `to`,
+// either of which may be NO_SLOT, once the attempt before it has changed.
+void CourseBook::countReplaced(const std::uint32_t slot, const std::uint32_t from, const std::uint32_t to) {
+    GpaTotals change;
+    if (from != NO_SLOT) {
+        change.add(slots_[from].credits, slots_[from].grade, scheme_);
+    }
+    if (to != NO_SLOT) {
+        change.add(-slots_[to].credits, slots_[to].grade, scheme_);
+    }
+    terms_.addCumulative(slots_[slot].term, change);
+}
+
+// Drops the tombstones in one pass. Slots keep their relative order, so the chains stay in
+// attempt order and only their links are renumbered, and the cumulative totals are unchanged.
+void CourseBook::compact() {
+    std::vector<std::uint32_t> renumbered(slots_.size(), NO_SLOT);
+    std::size_t live = 0;
+    for (std::size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (!removed_[slot]) {
+            renumbered[slot] = static_cast<std::uint32_t>(live);
+            slots_[live++] = slots_[slot];
+        }
+    }
+    slots_.resize(live);
+    const auto renumber = [&](std::uint32_t& slot) {
+        if (slot != NO_SLOT) {
+            slot = renumbered[slot];
+        }
+    };
+    for (auto& slot : slots_) {
+        renumber(slot.previousWithName);
+        renumber(slot.nextWithName);
+    }
+    for (auto& chain : nameChains_) {
+        renumber(chain.first);
+        renumber(chain.last);
+        for (auto& tail : chain.termTails) {
+            renumber(tail.slot);
+        }
+    }
+    removed_.assign(live, false);
+    // Every slot is live again: node i covers lowestBit(i) slots.
+    liveTree_.resize(live + 1);
+    liveTree_[0] = 0;
+    for (std::size_t node = 1; node <= live; ++node) {
+        liveTree_[node] = static_cast<std::uint32_t>(lowestBit(node));
+    }
+    tombstones_ = 0;
+}
+
+void CourseBook::checkTotals() const {
+#if defined(GPA_CALC_EXPENSIVE_CHECKS) && !defined(NDEBUG)
+    GpaTotals expected;
+    std::size_t chained = 0;
+    for (std::size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (!removed_[slot]) {
+            expected.add(slots_[slot].credits, slots_[slot].grade, scheme_);
+        }
+    }
+    assert(totals_ == expected);
+    for (std::size_t position = 0; position < size(); ++position) {
+        assert(positionOf(slotOf(position)) == position);
+    }
+    for (const auto& chain : nameChains_) {
+        std::uint32_t previous = NO_SLOT;
+        auto tail = chain.termTails.begin();
+        for (std::uint32_t slot = chain.first; slot != NO_SLOT; slot = slots_[slot].nextWithName) {
+            const std::uint32_t next = slots_[slot].nextWithName;
+            assert(!removed_[slot] && slots_[slot].previousWithName == previous);
+            assert(next == NO_SLOT ? chain.last == slot : laterAttempt(next, slot));
+            if (next == NO_SLOT || slots_[next].term != slots_[slot].term) {
+                assert(tail != chain.termTails.end() && tail->term == slots_[slot].term && tail->slot == slot);
+                ++tail;
+            }
+            previous = slot;
+            ++chained;
+        }
+        assert(tail == chain.termTails.end());
+    }
+    assert(chained == size());
+
+    // Replay the live courses in attempt order, keeping each name's latest attempt, and compare
+    // the running transcript with the tree at the end of every term.
+    std::vector<std::uint32_t> attempts;
+    for (std::size_t slot = 0; slot < slots_.size(); ++slot) {
+        if (!removed_[slot]) {
+            attempts.push_back(static_cast<std::uint32_t>(slot));
+        }
+    }
+    std::stable_sort(attempts.begin(), attempts.end(), [this](const std::uint32_t a, const std::uint32_t b) {
+        return slots_[a].term < slots_[b].term;
+    });
+    std::vector<std::uint32_t> latest(nameChains_.size(), NO_SLOT);
+    GpaTotals cumulative;
+    auto next = attempts.begin();
+    for (int term = 1; term <= MAX_TERM; ++term) {
+        GpaTotals taken;
+        for (; next != attempts.end() && slots_[*next].term == term; ++next) {
+            const Slot& attempt = slots_[*next];
+            taken.add(attempt.credits, attempt.grade, scheme_);
+            if (latest[attempt.name] != NO_SLOT) {
+                const Slot& replaced = slots_[latest[attempt.name]];
+                cumulative.add(-replaced.credits, replaced.grade, scheme_);
+            }
+            cumulative.add(attempt.credits, attempt.grade, scheme_);
+            latest[attempt.name] = *next;
+        }
+        const GpaTotals tree = terms_.cumulative(term);
+        assert(terms_.term(term) == taken && tree == cumulative);
+    }
+    for (std::size_t name = 0; name < nameChains_.size(); ++name) {
+        assert(nameChains_[name].last == latest[name]);
+    }
+#endif
+}
@@ -0,0 +1,162 @@
+#ifndef GPA_CALC_COURSE_BOOK_H
+#define GPA_CALC_COURSE_BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+#include "string_pool.h"
+#include "term_totals.h"
+
+// A student's courses together with running totals of credits and weighted points. Every
+// mutation adjusts the totals by the one course it touches, so the GPA and hour count are
+// available in O(1) however long the transcript is. Builds with GPA_CALC_EXPENSIVE_CHECKS defined
+// check the totals against a full O(n) recompute after each change.
+//
+// Courses are addressed by their 0-based position in the list. Deleting a course only leaves a
+// tombstone in its slot; a Fenwick tree over the live slots maps positions to slots in
+// O(log n), and remove() compacts the slots once tombstones outnumber live courses (as does
+// setScheme()), so no operation shifts the remaining courses. Iteration steps over tombstones,
+// so only the mutators move slots. A name index finds courses by exact name or prefix without
+// scanning the list.
+//
+// Each course belongs to a term. The book also keeps TermTotals: per-term totals, and cumulative
+// totals in which a course taken more than once counts only by its latest attempt (highest term,
+// then latest in the list), as the FCAI bylaw has retakes replace earlier grades. Each name's
+// chain is kept in that attempt order, and an attempt adds its points less those of the attempt
+// before it to the cumulative totals from its term on, so an edit adjusts only its own delta and
+// its successor's. The chain is doubly linked and each name remembers its latest attempt in every
+// term it was taken in, so adding or removing a course costs O(log MAX_TERM) without allocating
+// (bar the first course of a name in a new term). Moving a course to another name or term also
+// walks back past the attempts in that term that come later in the list.
+//
+// Grades count by the book's grading scheme, FCAI unless setScheme() picks another; every course
+// must have a grade on that scheme's scale.
+//
+// Names live in a StringPool, so each slot is a 16-byte record holding a 32-bit name ID and
+// repeated names are stored once; the slots sharing a name are chained through the records
+// themselves, so loading a book costs no allocation per course beyond each name's term index. Courses are handed out as
+// CourseViews whose names stay valid for the lifetime of the book. A book holds fewer than
+// 2^32 slots.
+class CourseBook {
+public:
+    class Iterator {
+    public:
+        Iterator(const CourseBook* courses, std::size_t slot) : courses_(courses), slot_(slot) { skipRemoved(); }
+        CourseView operator*() const { return courses_->viewOf(courses_->slots_[slot_]); }
+        Iterator& operator++() { ++slot_; skipRemoved(); return *this; }
+        bool operator==(const Iterator& other) const { return slot_ == other.slot_; }
+
+    private:
+        void skipRemoved() {
+            while (slot_ < courses_->slots_.size() && courses_->removed_[slot_]) {
+                ++slot_;
+            }
+        }
+
+        const CourseBook* courses_;
+        std::size_t slot_;
+    };
+
+    CourseBook() = default;
+    explicit CourseBook(const std::vector<Course>& courses);
+
+    void add(const CourseView& course);
+    void add(const Course& course) { add(CourseView{course.name, course.credits, course.grade, course.term}); }
+    void replace(std::size_t position, const CourseView& course);
+    void replace(std::size_t position, const Course& course) {
+        replace(position, CourseView{course.name, course.credits, course.grade, course.term});
+    }
+    void remove(std::size_t position);
+    void reserve(std::size_t courseCount);
+
+    std::size_t size() const { return slots_.size() - tombstones_; }
+    bool empty() const { return size() == 0; }
+    CourseView operator[](std::size_t position) const { return viewOf(slots_[slotOf(position)]); }
+    // Iterates the live courses in order, stepping over tombstones.
+    Iterator begin() const { return {this, 0}; }
+    Iterator end() const { return {this, slots_.size()}; }
+
+    // Positions of the courses named exactly `name`, in list order.
+    std::vector<std::size_t> findByName(std::string_view name) const;
+    // Positions of up to `limit` courses whose names start with `prefix`, in name order.
+    std::vector<std::size_t> findByPrefix(std::string_view prefix, std::size_t limit) const;
+
+    GradingScheme scheme() const { return scheme_; }
+    // Regrades every course under `scheme`, or returns false (changing nothing) if some course's
+    // grade is not on its scale.
+    bool setScheme(GradingScheme scheme);
+
+    // Every course, retaken or not.
+    const GpaTotals& totals() const { return totals_; }
+    // The transcript the GPA is reported from: each course once, by its latest attempt.
+    GpaTotals cumulative() const { return terms_.cumulative(MAX_TERM); }
+    const TermTotals& terms() const { return terms_; }
+    // Distinct names interned by the book (including names of since-deleted courses).
+    const StringPool& names() const { return names_; }
+
+private:
+    struct Slot {
+        StringPool::Id name;
+        // Neighbouring attempts with the same name, in attempt order.
+        std::uint32_t previousWithName;
+        std::uint32_t nextWithName;
+        std::uint8_t credits;
+        Grade grade;
+        std::uint8_t term;
+    };
+    // The latest attempt at a name within one term.
+    struct TermTail {
+        std::uint8_t term;
+        std::uint32_t slot;
+    };
+    // First and last (latest) attempt of each name's chain, and its term tails in term order,
+    // indexed by name ID.
+    struct NameChain {
+        std::uint32_t first;
+        std::uint32_t last;
+        std::vector<TermTail> termTails;
+    };
+
+    static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+    CourseView viewOf(const Slot& slot) const { return {names_[slot.name], slot.credits, slot.grade, slot.term}; }
+    bool laterAttempt(std::uint32_t slot, std::uint32_t than) const;
+    std::size_t slotOf(std::size_t position) const;
+    std::size_t positionOf(std::size_t slot) const;
+    StringPool::Id internName(std::string_view name);
+    void appendSlot(const Slot& slot);
+    void linkAttempt(std::uint32_t slot);
+    void unlinkAttempt(std::uint32_t slot);
+    void countLinked(std::uint32_t slot, int sign);
+    void countAttempt(std::uint32_t slot, std::uint32_t previous, int sign);
+    void countReplaced(std::uint32_t slot, std::uint32_t from, std::uint32_t to);
+    void compact();
+    void checkTotals() const;
+
+    std::vector<Slot> slots_;
+    std::vector<bool> removed_;
+    std::vector<std::uint32_t> liveTree_;
+    std::vector<NameChain> nameChains_;
+    StringPool names_;
+    // Name IDs in name order. This is a cache: findByPrefix() brings it up to date when new names
+    // were interned, so that const call writes it and must not run alongside other readers.
+    mutable std::vector<StringPool::Id> sortedNames_;
+    std::size_t tombstones_ = 0;
+    GradingScheme scheme_ = GradingScheme::Fcai;
+    GpaTotals totals_;
+    TermTotals terms_;
+};
+
+// The GPA and hours of the transcript, with retaken courses counted by their latest attempt.
+inline double calculateGPA(const CourseBook& courses) {
+    return courses.cumulative().gpa();
+}
+
+inline int totalHours(const CourseBook& courses) {
+    return courses.cumulative().credits;
+}
+
+#endif //GPA_CALC_COURSE_BOOK_H
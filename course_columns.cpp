@@ -0,0 +1,143 @@
+#include "course_columns.h"
+
+#include <numeric>
+
+#include "stats.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+void CourseColumns::reserve(const std::size_t count, const std::size_t namesSize) {
+    credits_.reserve(count);
+    pointTenths_.reserve(count);
+    grades_.reserve(count);
+    nameEnds_.reserve(count);
+    names_.reserve(namesSize);
+}
+
+void CourseColumns::add(const std::string_view name, const int credits, const Grade grade) {
+    names_.insert(names_.end(), name.begin(), name.end());
+    nameEnds_.push_back(names_.size());
+    credits_.push_back(credits);
+    pointTenths_.push_back(gradeTenths(grade, scheme_));
+    grades_.push_back(grade);
+}
+
+void CourseColumns::clear() {
+    credits_.clear();
+    pointTenths_.clear();
+    grades_.clear();
+    names_.clear();
+    nameEnds_.clear();
+}
+
+std::string_view CourseColumns::name(const std::size_t index) const {
+    const std::uint64_t begin = index == 0 ? 0 : nameEnds_[index - 1];
+    return {names_.data() + begin, nameEnds_[index] - begin};
+}
+
+WeightedSums weightedSums(const std::int32_t* credits, const std::int32_t* pointTenths, const std::size_t count) {
+    std::size_t i = 0;
+    WeightedSums sums;
+
+#if defined(__AVX2__)
+    // Both columns are widened to 64-bit lanes, so products and sums can't overflow. Two
+    // independent accumulator pairs hide the latency of the dependent adds.
+    __m256i points0 = _mm256_setzero_si256(), points1 = _mm256_setzero_si256();
+    __m256i credits0 = _mm256_setzero_si256(), credits1 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        const __m256i c0 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(credits + i)));
+        const __m256i c1 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(credits + i + 4)));
+        const __m256i t0 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pointTenths + i)));
+        const __m256i t1 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pointTenths + i + 4)));
+        points0 = _mm256_add_epi64(points0, _mm256_mul_epi32(c0, t0));
+        points1 = _mm256_add_epi64(points1, _mm256_mul_epi32(c1, t1));
+        credits0 = _mm256_add_epi64(credits0, c0);
+        credits1 = _mm256_add_epi64(credits1, c1);
+    }
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(points0, points1));
+    sums.pointTenths = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(credits0, credits1));
+    sums.credits = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE4_1__)
+    __m128i points0 = _mm_setzero_si128(), points1 = _mm_setzero_si128();
+    __m128i credits0 = _mm_setzero_si128(), credits1 = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(credits + i));
+        const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointTenths + i));
+        const __m128i c0 = _mm_cvtepi32_epi64(c);
+        const __m128i c1 = _mm_cvtepi32_epi64(_mm_srli_si128(c, 8));
+        points0 = _mm_add_epi64(points0, _mm_mul_epi32(c0, _mm_cvtepi32_epi64(t)));
+        points1 = _mm_add_epi64(points1, _mm_mul_epi32(c1, _mm_cvtepi32_epi64(_mm_srli_si128(t, 8))));
+        credits0 = _mm_add_epi64(credits0, c0);
+        credits1 = _mm_add_epi64(credits1, c1);
+    }
+    alignas(16) std::int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(points0, points1));
+    sums.pointTenths = lanes[0] + lanes[1];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(credits0, credits1));
+    sums.credits = lanes[0] + lanes[1];
+#elif defined(__SSE2__) || defined(_M_X64)
+    // SSE2, the x86-64 baseline, has no 32-bit multiply, but credits and tenths are small: packed
+    // to 16 bits, one madd gives two exact products per lane as long as every value is in
+    // [0, 2^15). The values are OR-ed together to check that, and if one isn't the sums are redone
+    // by the exact loop below.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i points = zero, hours = zero, bits = zero;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(credits + i));
+        const __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(credits + i + 4));
+        const __m128i t0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointTenths + i));
+        const __m128i t1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointTenths + i + 4));
+        bits = _mm_or_si128(bits, _mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(t0, t1)));
+        const __m128i c = _mm_packs_epi32(c0, c1);
+        const __m128i products = _mm_madd_epi16(c, _mm_packs_epi32(t0, t1));
+        const __m128i pairs = _mm_madd_epi16(c, ones);
+        points = _mm_add_epi64(points, _mm_add_epi64(_mm_unpacklo_epi32(products, zero),
+                                                     _mm_unpackhi_epi32(products, zero)));
+        hours = _mm_add_epi64(hours, _mm_add_epi64(_mm_unpacklo_epi32(pairs, zero), _mm_unpackhi_epi32(pairs, zero)));
+    }
+    const __m128i outOfRange = _mm_and_si128(bits, _mm_set1_epi32(~0x7FFF));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(outOfRange, zero)) == 0xFFFF) {
+        alignas(16) std::int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), points);
+        sums.pointTenths = lanes[0] + lanes[1];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), hours);
+        sums.credits = lanes[0] + lanes[1];
+    } else {
+        i = 0;
+    }
+#else
+    // Plain integer adds, which the compiler is free to vectorise for whatever the target has.
+    std::int64_t points0 = 0, points1 = 0, credits0 = 0, credits1 = 0;
+    for (; i + 2 <= count; i += 2) {
+        points0 += static_cast<std::int64_t>(credits[i]) * pointTenths[i];
+        points1 += static_cast<std::int64_t>(credits[i + 1]) * pointTenths[i + 1];
+        credits0 += credits[i];
+        credits1 += credits[i + 1];
+    }
+    sums.pointTenths = points0 + points1;
+    sums.credits = credits0 + credits1;
+#endif
+
+    for (; i < count; ++i) {
+        sums.pointTenths += static_cast<std::int64_t>(credits[i]) * pointTenths[i];
+        sums.credits += credits[i];
+    }
+    return sums;
+}
+
+double allAttemptsGPA(const CourseColumns& courses) {
+    const ScopedTimer timer(StatTimer::CalculateGPA);
+    const WeightedSums sums = weightedSums(courses.credits(), courses.pointTenths(), courses.size());
+    return sums.credits == 0 ? 0.0 : static_cast<double>(sums.pointTenths) / (10.0 * static_cast<double>(sums.credits));
+}
+
+int allAttemptsHours(const CourseColumns& courses) {
+    return std::accumulate(courses.credits(), courses.credits() + courses.size(), 0);
+}
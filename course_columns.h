@@ -0,0 +1,58 @@
+#ifndef GPA_CALC_COURSE_COLUMNS_H
+#define GPA_CALC_COURSE_COLUMNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+
+// Structure-of-arrays course storage: credits, points (in tenths) and grades each live in their own
+// contiguous array and names are packed into one character buffer, so aggregate passes stream through
+// only the bytes they need instead of striding over whole Course objects. Points are taken from the
+// columns' grading scheme, FCAI unless the constructor picks another, and every grade added must be
+// on its scale.
+class CourseColumns {
+public:
+    CourseColumns() = default;
+    explicit CourseColumns(const GradingScheme scheme) : scheme_(scheme) {}
+
+    void reserve(std::size_t count, std::size_t namesSize = 0);
+    void add(std::string_view name, int credits, Grade grade);
+    void add(const Course& course) { add(course.name, course.credits, course.grade); }
+    void clear();
+
+    std::size_t size() const { return credits_.size(); }
+    bool empty() const { return credits_.empty(); }
+    std::string_view name(std::size_t index) const;
+    CourseView operator[](std::size_t index) const { return {name(index), credits_[index], grades_[index]}; }
+
+    GradingScheme scheme() const { return scheme_; }
+    const std::int32_t* credits() const { return credits_.data(); }
+    const std::int32_t* pointTenths() const { return pointTenths_.data(); }
+
+private:
+    GradingScheme scheme_ = GradingScheme::Fcai;
+    std::vector<std::int32_t> credits_;
+    std::vector<std::int32_t> pointTenths_;
+    std::vector<Grade> grades_;
+    std::vector<char> names_;
+    std::vector<std::uint64_t> nameEnds_;
+};
+
+struct WeightedSums {
+    std::int64_t pointTenths = 0;
+    std::int64_t credits = 0;
+};
+
+// Computes sum(pointTenths * credits) and sum(credits) in a single fused pass, using SSE2, SSE4.1
+// or AVX2 vectors, whichever is the best the target supports. All arithmetic is exact 64-bit integer math, so the
+// sums are the same whatever the vector width or the order of the courses.
+WeightedSums weightedSums(const std::int32_t* credits, const std::int32_t* pointTenths, std::size_t count);
+
+// Over every row, retakes included: the columns have no terms to apply the retake rule with.
+double allAttemptsGPA(const CourseColumns& courses);
+int allAttemptsHours(const CourseColumns& courses);
+
+#endif //GPA_CALC_COURSE_COLUMNS_H
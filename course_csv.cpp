@@ -0,0 +1,266 @@
+#include "course_csv.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+#include "atomic_file.h"
+#include "mapped_file.h"
+#include "stats.h"
+#include "storage.h"
+#include "text_reader.h"
+#include "validation.h"
+
+namespace {
+
+constexpr std::size_t NO_COLUMN = static_cast<std::size_t>(-1);
+
+struct CsvField {
+    std::string_view text;
+    bool quoted = false;
+    // Quoted and holding doubled quotes, so the text has to be unescaped before use.
+    bool escaped = false;
+};
+
+// Splits the record at `cursor` into fields and moves `cursor` to the start of the next record,
+// counting the line breaks it passes in `lines`. Returns false for a quote that is never closed or
+// is followed by something other than a delimiter; the rest of that line is then skipped.
+bool splitRecord(const char*& cursor, const char* end, std::vector<CsvField>& fields, std::size_t& lines) {
+    fields.clear();
+    while (true) {
+        CsvField field;
+        if (cursor < end && *cursor == '"') {
+            const char* start = ++cursor;
+            const char* quote;
+            // A quoted field runs to the first quote that isn't doubled, across line breaks.
+            while (true) {
+                quote = static_cast<const char*>(std::memchr(cursor, '"', end - cursor));
+                if (!quote) {
+                    lines += std::count(start, end, '\n');
+                    cursor = end;
+                    return false;
+                }
+                if (quote + 1 < end && quote[1] == '"') {
+                    field.escaped = true;
+                    cursor = quote + 2;
+                    continue;
+                }
+                break;
+            }
+            field.text = std::string_view(start, quote - start);
+            field.quoted = true;
+            lines += std::count(field.text.begin(), field.text.end(), '\n');
+            cursor = quote + 1;
+            if (cursor < end && *cursor == '\r' && (cursor + 1 == end || cursor[1] == '\n')) ++cursor;
+            if (cursor < end && *cursor != ',' && *cursor != '\n') {
+                const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+                cursor = newline ? newline + 1 : end;
+                ++lines;
+                return false;
+            }
+        } else {
+            const char* start = cursor;
+            while (cursor < end && *cursor != ',' && *cursor != '\n') ++cursor;
+            field.text = std::string_view(start, cursor - start);
+            if (!field.text.empty() && field.text.back() == '\r' && (cursor == end || *cursor == '\n')) {
+                field.text.remove_suffix(1);
+            }
+        }
+        fields.push_back(field);
+        if (cursor == end) {
+            ++lines;
+            return true;
+        }
+        if (*cursor++ == '\n') {
+            ++lines;
+            return true;
+        }
+    }
+}
+
+bool equalsIgnoreCase(const std::string_view a, const std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+void appendName(std::string& buffer, const std::string_view name) {
+    bool quote = !name.empty() && (std::isspace(static_cast<unsigned char>(name.front()))
+                                   || std::isspace(static_cast<unsigned char>(name.back())));
+    for (const char c : name) {
+        quote = quote || c == ',' || c == '"' || c == '\n' || c == '\r';
+    }
+    if (!quote) {
+        buffer += name;
+        return;
+    }
+    buffer += '"';
+    for (const char c : name) {
+        if (c == '"') buffer += '"';
+        buffer += c;
+    }
+    buffer += '"';
+}
+
+template <typename CourseList>
+bool saveCsv(const CourseList& courses, const std::string& filename, const GradingScheme scheme) {
+    const ScopedTimer timer(StatTimer::SaveCourses);
+    AtomicFile outFile;
+    if (!outFile.open(filename)) {
+        std::cerr << "Error: Could not open file for saving: " << filename << std::endl;
+        return false;
+    }
+
+    // There are only 13 grades, so their ",letter,points," columns are formatted once up front.
+    char number[32];
+    std::array<std::string, GRADE_COUNT> gradeColumns;
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        const auto grade = static_cast<Grade>(code);
+        gradeColumns[code] = ',';
+        gradeColumns[code] += gradeLetter(grade);
+        gradeColumns[code] += ',';
+        gradeColumns[code].append(number, std::to_chars(number, number + sizeof(number), gradePoints(grade, scheme)).ptr);
+        gradeColumns[code] += ',';
+    }
+
+    std::string buffer;
+    buffer.reserve(IO_BUFFER_SIZE + 1024);
+    buffer += CSV_HEADER;
+    buffer += '\n';
+    bool written = true;
+    for (const auto& course : courses) {
+        appendName(buffer, course.name);
+        buffer += ',';
+        buffer.append(number, std::to_chars(number, number + sizeof(number), course.credits).ptr);
+        buffer += gradeColumns[static_cast<std::size_t>(course.grade)];
+        buffer.append(number, std::to_chars(number, number + sizeof(number), course.term).ptr);
+        buffer += '\n';
+        if (buffer.size() >= IO_BUFFER_SIZE) {
+            written = written && outFile.write(buffer);
+            buffer.clear();
+        }
+    }
+    written = written && outFile.write(buffer);
+    if (!written || !outFile.commit()) {
+        std::cerr << "Error: Could not write CSV file: " << filename << std::endl;
+        return false;
+    }
+    Stats::add(StatCounter::BytesWritten, outFile.size());
+    return true;
+}
+
+} // namespace
+
+bool isCsvFile(const std::string_view filename) {
+    constexpr std::string_view EXTENSION = ".csv";
+    return filename.size() > EXTENSION.size()
+           && equalsIgnoreCase(filename.substr(filename.size() - EXTENSION.size()), EXTENSION);
+}
+
+bool saveCoursesCsv(const std::vector<Course>& courses, const std::string& filename, const GradingScheme scheme) {
+    return saveCsv(courses, filename, scheme);
+}
+
+bool saveCoursesCsv(const CourseBook& courses, const std::string& filename) {
+    return saveCsv(courses, filename, courses.scheme());
+}
+
+bool loadCoursesCsv(CourseBook& courses, int& unnamedCounter, const std::string& filename, std::size_t& rejected) {
+    const ScopedTimer timer(StatTimer::LoadCourses);
+    rejected = 0;
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Error: Could not open CSV file: " << filename << std::endl;
+        return false;
+    }
+    Stats::add(StatCounter::BytesRead, file.size());
+
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
+    // Spreadsheets often start UTF-8 exports with a byte order mark.
+    if (end - cursor >= 3 && std::memcmp(cursor, "\xEF\xBB\xBF", 3) == 0) {
+        cursor += 3;
+    }
+
+    std::vector<CsvField> fields;
+    std::size_t lines = 0;
+    std::size_t nameColumn = NO_COLUMN;
+    std::size_t creditsColumn = NO_COLUMN;
+    std::size_t gradeColumn = NO_COLUMN;
+    std::size_t termColumn = NO_COLUMN;
+    splitRecord(cursor, end, fields, lines);
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        const std::string_view column = trim(fields[i].text);
+        if (equalsIgnoreCase(column, "name")) nameColumn = i;
+        else if (equalsIgnoreCase(column, "credits")) creditsColumn = i;
+        else if (equalsIgnoreCase(column, "grade")) gradeColumn = i;
+        else if (equalsIgnoreCase(column, "term")) termColumn = i;
+    }
+    if (nameColumn == NO_COLUMN || creditsColumn == NO_COLUMN || gradeColumn == NO_COLUMN) {
+        std::cerr << "Error: " << filename << " has no name, credits and grade columns." << std::endl;
+        return false;
+    }
+    const std::size_t columns = std::max({nameColumn, creditsColumn, gradeColumn,
+                                          termColumn == NO_COLUMN ? 0 : termColumn}) + 1;
+
+    InputReport report;
+    std::string name;
+    std::size_t rows = 0;
+    while (cursor < end) {
+        InputIssue issue{InputError::None, lines + 1, 0};
+        const bool split = splitRecord(cursor, end, fields, lines);
+        if (split && fields.size() == 1 && !fields[0].quoted && trim(fields[0].text).empty()) {
+            continue;
+        }
+
+        CourseView course{};
+        if (!split) {
+            issue.error = InputError::BadQuoting;
+        } else if (fields.size() < columns) {
+            issue.error = InputError::MissingField;
+        } else if (fields[nameColumn].text.find_first_of("\r\n") != std::string_view::npos) {
+            // Data files keep one name per line, so names can't span lines.
+            issue = {InputError::LineBreakInName, issue.line, nameColumn + 1};
+        } else if ((issue.error = checkCredits(fields[creditsColumn].text, course.credits)) != InputError::None) {
+            issue.column = creditsColumn + 1;
+        } else if ((issue.error = checkGrade(fields[gradeColumn].text, courses.scheme(), course.grade))
+                   != InputError::None) {
+            issue.column = gradeColumn + 1;
+        } else if (termColumn != NO_COLUMN
+                   && (issue.error = checkTerm(fields[termColumn].text, course.term)) != InputError::None) {
+            issue.column = termColumn + 1;
+        }
+        if (issue.error != InputError::None) {
+            report.add(issue);
+            continue;
+        }
+
+        const CsvField& nameField = fields[nameColumn];
+        std::string_view courseName = nameField.quoted ? nameField.text : trim(nameField.text);
+        if (nameField.escaped) {
+            name.clear();
+            for (std::size_t i = 0; i < courseName.size(); ++i) {
+                name += courseName[i];
+                if (courseName[i] == '"') ++i;
+            }
+            courseName = name;
+        }
+        if (courseName.empty() || courseName == "0") {
+            name = courseNameOrDefault(std::string(), unnamedCounter);
+            courseName = name;
+        } else {
+            updateUnnamedCounter(courseName, unnamedCounter);
+        }
+        course.name = courseName;
+        courses.add(course);
+        ++rows;
+    }
+    report.print(std::cerr, filename);
+    rejected = report.rejected();
+    Stats::add(StatCounter::RowsParsed, rows);
+    Stats::add(StatCounter::RowsRejected, rejected);
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef GPA_CALC_COURSE_CSV_H
+#define GPA_CALC_COURSE_CSV_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+#include "course_book.h"
+
+// Column header of exported CSV files. Points are the grade's value on the book's grading scheme,
+// for spreadsheets and BI tools; imports ignore them and take the grade letter.
+inline constexpr std::string_view CSV_HEADER = "name,credits,grade,points,term";
+
+// True for filenames ending in ".csv" (in any case), which --import and --export read and write as CSV.
+bool isCsvFile(std::string_view filename);
+
+// Writes one RFC 4180 line per course under CSV_HEADER. Names are quoted only when they hold a
+// comma, quote, line break or surrounding space. Rows are formatted into a large buffer that is
+// written a block at a time, through an AtomicFile. Returns false (after reporting the error) if
+// the file couldn't be written.
+bool saveCoursesCsv(const std::vector<Course>& courses, const std::string& filename,
+                    GradingScheme scheme = GradingScheme::Fcai);
+bool saveCoursesCsv(const CourseBook& courses, const std::string& filename);
+
+// Adds the courses of a CSV file to the book, on the book's grading scheme. The first line names
+// the columns: name, credits and grade are required, term is optional (term 1), and other columns
+// are ignored, so the order and extra columns of a spreadsheet export don't matter. The file is
+// mapped and split in place, with quoted fields (which may span lines) only copied for unescaping.
+// Records with bad credits, an off-scale grade, a bad term or a name spanning lines are skipped,
+// counted in `rejected` and reported on standard error with their line and column. Empty names become "Unnamed Course N". Returns false if the
+// file can't be opened or its header lacks a required column.
+bool loadCoursesCsv(CourseBook& courses, int& unnamedCounter, const std::string& filename, std::size_t& rejected);
+
+#endif //GPA_CALC_COURSE_CSV_H
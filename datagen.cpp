@@ -0,0 +1,88 @@
+#include "datagen.h"
+
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <string_view>
+
+#include "text_reader.h"
+
+namespace {
+
+constexpr std::array<std::string_view, 24> COURSE_NAMES = {
+    "CS111 Fundamentals of Programming", "CS112 Structured Programming", "CS213 Object Oriented Programming",
+    "CS214 Data Structures", "CS221 Digital Design", "CS251 Software Engineering I",
+    "CS311 Artificial Intelligence", "CS316 Algorithms", "CS321 Computer Architecture",
+    "CS341 Operating Systems", "CS352 Compilers", "CS361 Computer Networks",
+    "IS211 Database Systems", "IS231 Web Technologies", "IS312 Information Retrieval",
+    "IT221 Signals and Systems", "IT352 Computer Graphics", "DS211 Probability and Statistics",
+    "DS321 Machine Learning", "MA111 Mathematics I", "MA112 Discrete Mathematics",
+    "MA214 Linear Algebra", "HU111 Technical Writing", "HU121 Critical Thinking",
+};
+
+// One course in 25 is left unnamed, like courses added without a name.
+constexpr int UNNAMED_WEIGHT = 1;
+
+} // namespace
+
+CourseGenerator::CourseGenerator(const std::uint64_t seed)
+    : random_(seed),
+      credits_({1, 3, 15, 65, 16}),
+      grades_({6, 9, 9, 10, 11, 10, 9, 9, 7, 6, 5, 4, 5}),
+      names_(0, static_cast<int>(COURSE_NAMES.size()) + UNNAMED_WEIGHT - 1) {}
+
+void CourseGenerator::next(Course& course) {
+    const int name = names_(random_);
+    if (name < static_cast<int>(COURSE_NAMES.size())) {
+        course.name.assign(COURSE_NAMES[name]);
+    } else {
+        course.name.assign("Unnamed Course ");
+        course.name += std::to_string(++unnamedCounter_);
+    }
+    course.credits = credits_(random_);
+    course.grade = static_cast<Grade>(grades_(random_));
+}
+
+Course CourseGenerator::next() {
+    Course course;
+    next(course);
+    return course;
+}
+
+std::vector<Course> generateCourses(const std::size_t count, const std::uint64_t seed) {
+    CourseGenerator generator(seed);
+    std::vector<Course> courses;
+    courses.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        courses.push_back(generator.next());
+    }
+    return courses;
+}
+
+bool generateCourseFile(const std::string& filename, const std::size_t count, const std::uint64_t seed) {
+    std::ofstream outFile(filename, std::ios::binary);
+    if (!outFile.is_open()) {
+        return false;
+    }
+
+    CourseGenerator generator(seed);
+    Course course;
+    std::string buffer;
+    buffer.reserve(IO_BUFFER_SIZE + 256);
+    char number[32];
+    for (std::size_t i = 0; i < count; ++i) {
+        generator.next(course);
+        buffer += course.name;
+        buffer += '\n';
+        buffer += static_cast<char>('0' + course.credits);
+        buffer += '\n';
+        buffer.append(number, std::to_chars(number, number + sizeof(number), gradePoints(course.grade)).ptr);
+        buffer += '\n';
+        if (buffer.size() >= IO_BUFFER_SIZE) {
+            outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    return static_cast<bool>(outFile);
+}
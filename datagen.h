@@ -0,0 +1,36 @@
+#ifndef GPA_CALC_DATAGEN_H
+#define GPA_CALC_DATAGEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "course.h"
+
+// Deterministic source of realistic synthetic courses for benchmarks: FCAI-style course codes
+// and titles with a sprinkling of "Unnamed Course N", mostly 3-hour courses, and grades drawn
+// from POINTS_MAP with more weight in the middle of the scale.
+class CourseGenerator {
+public:
+    explicit CourseGenerator(std::uint64_t seed = 42);
+
+    // Fills `course` in place so callers can reuse its name buffer.
+    void next(Course& course);
+    Course next();
+
+private:
+    std::mt19937_64 random_;
+    std::discrete_distribution<int> credits_;
+    std::discrete_distribution<int> grades_;
+    std::uniform_int_distribution<int> names_;
+    int unnamedCounter_ = 0;
+};
+
+std::vector<Course> generateCourses(std::size_t count, std::uint64_t seed = 42);
+
+// Streams `count` generated courses into a text data file in constant memory.
+bool generateCourseFile(const std::string& filename, std::size_t count, std::uint64_t seed = 42);
+
+#endif //GPA_CALC_DATAGEN_H
@@ -0,0 +1,212 @@
+#ifndef GPA_CALC_GRADING_H
+#define GPA_CALC_GRADING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+// Letter grades of the FCAI-CU bylaw. The underlying value is the grade's compact code, used to
+// index POINTS_MAP and GRADE_MAP and stored as-is in binary data files.
+enum class Grade : std::uint8_t {
+    APlus, A, AMinus, BPlus, B, BMinus, CPlus, C, CMinus, DPlus, D, DMinus, F
+};
+
+inline constexpr int GRADE_COUNT = 13;
+
+inline constexpr std::array<double, GRADE_COUNT> POINTS_MAP = {
+    4.0, 3.7, 3.4, 3.2, 3.0, 2.8, 2.6, 2.4, 2.2, 2.0, 1.5, 1.0, 0.0
+};
+
+inline constexpr std::array<std::string_view, GRADE_COUNT> GRADE_MAP = {
+    "A+", "A", "A-", "B+", "B", "B-", "C+", "C", "C-", "D+", "D", "D-", "F"
+};
+
+// POINTS_MAP in tenths of a point. Every grade is worth a whole number of tenths, so GPA sums
+// are kept in tenths as exact integers, and only the final GPA is a floating-point value.
+inline constexpr std::array<std::int32_t, GRADE_COUNT> POINT_TENTHS = {
+    40, 37, 34, 32, 30, 28, 26, 24, 22, 20, 15, 10, 0
+};
+
+// Bylaws a transcript can be graded under. Every scheme uses the letters of Grade, though not
+// necessarily all of them, and gives each a whole number of tenths of a point. The value is
+// stored in data file headers.
+enum class GradingScheme : std::uint8_t {
+    // The FCAI-CU credit-hour bylaw (POINT_TENTHS), and the default.
+    Fcai,
+    // The earlier FCAI scale: A, B+, B, C+, C, D+, D and F in half-point steps.
+    FcaiOld,
+    // A US-style plus/minus scale on which A+ is worth 4.3.
+    Us43
+};
+
+inline constexpr int SCHEME_COUNT = 3;
+
+// Tenths of a grade a scheme doesn't use.
+inline constexpr std::int32_t OFF_SCALE = -1;
+
+struct GradeScale {
+    std::string_view name;
+    std::array<std::int32_t, GRADE_COUNT> tenths;
+};
+
+// Indexed by GradingScheme. The tables are constants, so code that fixes the scheme as a template
+// argument (see withScheme()) looks grades up with no indirection at all.
+inline constexpr std::array<GradeScale, SCHEME_COUNT> GRADE_SCALES = {{
+    {"fcai", POINT_TENTHS},
+    {"fcai-old", {OFF_SCALE, 40, OFF_SCALE, 35, 30, OFF_SCALE, 25, 20, OFF_SCALE, 15, 10, OFF_SCALE, 0}},
+    {"us43", {43, 40, 37, 33, 30, 27, 23, 20, 17, 13, 10, 7, 0}},
+}};
+
+// Every scale runs strictly down from its first grade to F = 0, so its points identify its grades.
+static_assert([] {
+    for (const auto& scale : GRADE_SCALES) {
+        std::int32_t previous = INT32_MAX;
+        for (const std::int32_t tenths : scale.tenths) {
+            if (tenths == OFF_SCALE) continue;
+            if (tenths >= previous) return false;
+            previous = tenths;
+        }
+        if (scale.tenths[GRADE_COUNT - 1] != 0) return false;
+    }
+    return true;
+}(), "grade scales must be strictly decreasing and end with F = 0");
+
+template <GradingScheme Scheme>
+inline constexpr const GradeScale& SCALE = GRADE_SCALES[static_cast<std::size_t>(Scheme)];
+
+template <GradingScheme Scheme = GradingScheme::Fcai>
+constexpr std::int32_t gradeTenths(const Grade grade) {
+    return SCALE<Scheme>.tenths[static_cast<std::size_t>(grade)];
+}
+
+constexpr std::int32_t gradeTenths(const Grade grade, const GradingScheme scheme) {
+    return GRADE_SCALES[static_cast<std::size_t>(scheme)].tenths[static_cast<std::size_t>(grade)];
+}
+
+template <GradingScheme Scheme = GradingScheme::Fcai>
+constexpr double gradePoints(const Grade grade) {
+    return gradeTenths<Scheme>(grade) / 10.0;
+}
+
+constexpr double gradePoints(const Grade grade, const GradingScheme scheme) {
+    return gradeTenths(grade, scheme) / 10.0;
+}
+
+static_assert([] {
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        if (gradePoints(static_cast<Grade>(code)) != POINTS_MAP[code]) return false;
+    }
+    return true;
+}(), "POINT_TENTHS must match POINTS_MAP");
+
+constexpr bool onScale(const Grade grade, const GradingScheme scheme) {
+    return gradeTenths(grade, scheme) != OFF_SCALE;
+}
+
+// Best grade of the scheme.
+constexpr Grade topGrade(const GradingScheme scheme) {
+    int code = 0;
+    while (!onScale(static_cast<Grade>(code), scheme)) {
+        ++code;
+    }
+    return static_cast<Grade>(code);
+}
+
+constexpr std::string_view gradeLetter(const Grade grade) {
+    return GRADE_MAP[static_cast<std::size_t>(grade)];
+}
+
+// Parses a letter grade such as "A+" or "c-" (case-insensitive, no surrounding spaces).
+constexpr std::optional<Grade> parseGrade(const std::string_view letter) {
+    if (letter.empty() || letter.size() > 2) {
+        return std::nullopt;
+    }
+    int base;
+    switch (letter[0]) {
+        case 'A': case 'a': base = static_cast<int>(Grade::A); break;
+        case 'B': case 'b': base = static_cast<int>(Grade::B); break;
+        case 'C': case 'c': base = static_cast<int>(Grade::C); break;
+        case 'D': case 'd': base = static_cast<int>(Grade::D); break;
+        case 'F': case 'f': return letter.size() == 1 ? std::optional(Grade::F) : std::nullopt;
+        default: return std::nullopt;
+    }
+    if (letter.size() == 1) {
+        return static_cast<Grade>(base);
+    }
+    switch (letter[1]) {
+        case '+': return static_cast<Grade>(base - 1);
+        case '-': return static_cast<Grade>(base + 1);
+        default: return std::nullopt;
+    }
+}
+
+// Parses a letter grade that is on the scheme's scale.
+template <GradingScheme Scheme>
+constexpr std::optional<Grade> parseGrade(const std::string_view letter) {
+    const auto grade = parseGrade(letter);
+    return grade && gradeTenths<Scheme>(*grade) != OFF_SCALE ? grade : std::nullopt;
+}
+
+constexpr std::optional<Grade> parseGrade(const std::string_view letter, const GradingScheme scheme) {
+    const auto grade = parseGrade(letter);
+    return grade && onScale(*grade, scheme) ? grade : std::nullopt;
+}
+
+// Maps a grade point value back to its grade, tolerating the rounding of a text round-trip.
+constexpr std::optional<Grade> gradeFromPoints(const double points,
+                                               const GradingScheme scheme = GradingScheme::Fcai) {
+    for (int code = 0; code < GRADE_COUNT; ++code) {
+        const auto grade = static_cast<Grade>(code);
+        const double difference = gradePoints(grade, scheme) - points;
+        if (onScale(grade, scheme) && difference < 1e-6 && difference > -1e-6) {
+            return grade;
+        }
+    }
+    return std::nullopt;
+}
+
+// Decodes a stored grade code; out-of-range codes from corrupt files, and codes off the scheme's
+// scale, read as F.
+constexpr Grade gradeFromCode(const unsigned code, const GradingScheme scheme = GradingScheme::Fcai) {
+    return code < GRADE_COUNT && onScale(static_cast<Grade>(code), scheme) ? static_cast<Grade>(code) : Grade::F;
+}
+
+static_assert(parseGrade("A+") == Grade::APlus && parseGrade("b-") == Grade::BMinus && parseGrade("F") == Grade::F);
+static_assert(!parseGrade("F+") && !parseGrade("E") && !parseGrade("A*"));
+static_assert(gradeFromPoints(1.5) == Grade::D && gradeLetter(Grade::DMinus) == "D-");
+static_assert(!parseGrade<GradingScheme::FcaiOld>("A-") && parseGrade<GradingScheme::FcaiOld>("b+") == Grade::BPlus);
+static_assert(gradeFromPoints(3.3, GradingScheme::Us43) == Grade::BPlus && !gradeFromPoints(3.3));
+static_assert(topGrade(GradingScheme::FcaiOld) == Grade::A && gradePoints<GradingScheme::Us43>(Grade::APlus) == 4.3);
+
+constexpr std::string_view schemeName(const GradingScheme scheme) {
+    return GRADE_SCALES[static_cast<std::size_t>(scheme)].name;
+}
+
+constexpr std::optional<GradingScheme> parseScheme(const std::string_view name) {
+    for (int scheme = 0; scheme < SCHEME_COUNT; ++scheme) {
+        if (GRADE_SCALES[scheme].name == name) {
+            return static_cast<GradingScheme>(scheme);
+        }
+    }
+    return std::nullopt;
+}
+
+// Runtime dispatch: calls `function` with a std::integral_constant holding `scheme`, so it is
+// instantiated once per scheme and each instantiation sees its tables as compile-time constants.
+// Pick the scheme once per file or roster, outside the loop over its courses.
+template <typename Function>
+decltype(auto) withScheme(const GradingScheme scheme, Function&& function) {
+    switch (scheme) {
+        case GradingScheme::FcaiOld:
+            return function(std::integral_constant<GradingScheme, GradingScheme::FcaiOld>{});
+        case GradingScheme::Us43:
+            return function(std::integral_constant<GradingScheme, GradingScheme::Us43>{});
+        default:
+            return function(std::integral_constant<GradingScheme, GradingScheme::Fcai>{});
+    }
+}
+
+#endif //GPA_CALC_GRADING_H
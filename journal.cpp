@@ -0,0 +1,354 @@
+#include "journal.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "mapped_file.h"
+#include "stats.h"
+#include "storage.h"
+#include "text_reader.h"
+#include "validation.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+void appendCourse(std::string& record, const CourseView& course) {
+    record += std::to_string(course.term);
+    record += '\t';
+    record += std::to_string(course.credits);
+    record += '\t';
+    record += gradeLetter(course.grade);
+    record += '\t';
+    record += course.name;
+    record += '\n';
+}
+
+// Applies one record to the book. Returns false for malformed records and out-of-range indices.
+bool applyRecord(std::string_view line, CourseBook& courses, int& unnamedCounter) {
+    const std::string_view type = nextField(line);
+    if (type == "T" || type == "A") {
+        CourseView course{};
+        if (parseCourseFields(line, type == "T", courses.scheme(), course).error != InputError::None) return false;
+        updateUnnamedCounter(course.name, unnamedCounter);
+        courses.add(course);
+        return true;
+    }
+    if (type == "R" || type == "E" || type == "D") {
+        std::size_t index;
+        if (!parseNumber(nextField(line), index) || index >= courses.size()) {
+            return false;
+        }
+        if (type == "D") {
+            courses.remove(index);
+            return true;
+        }
+        CourseView course{};
+        if (parseCourseFields(line, type == "R", courses.scheme(), course).error != InputError::None) return false;
+        updateUnnamedCounter(course.name, unnamedCounter);
+        courses.replace(index, course);
+        return true;
+    }
+    if (type == "G") {
+        const auto scheme = parseScheme(line);
+        return scheme && courses.setScheme(*scheme);
+    }
+    if (type == "S") {
+        const GradingScheme scheme = courses.scheme();
+        courses = CourseBook();
+        courses.setScheme(scheme);
+        return true;
+    }
+    return type == "C";
+}
+
+} // namespace
+
+Journal::Journal(std::string filename) : filename_(std::move(filename)) {}
+
+Journal::~Journal() {
+    if (file_) {
+        syncFile(file_);
+        std::fclose(file_);
+    }
+}
+
+std::size_t Journal::replay(CourseBook& courses, int& unnamedCounter) {
+    bool complete = true;
+    const std::size_t uncommitted = apply(courses, unnamedCounter, complete);
+    if (!complete) {
+        std::cerr << "Warning: Discarding an incomplete record at the end of " << filename_ << "\n";
+        std::error_code error;
+        std::filesystem::resize_file(filename_, size_, error);
+    }
+    return uncommitted;
+}
+
+std::size_t Journal::read(CourseBook& courses, int& unnamedCounter) {
+    bool complete = true;
+    const std::size_t uncommitted = apply(courses, unnamedCounter, complete);
+    if (!complete) {
+        std::cerr << "Warning: Ignoring an incomplete record at the end of " << filename_ << "\n";
+    }
+    return uncommitted;
+}
+
+std::size_t Journal::apply(CourseBook& courses, int& unnamedCounter, bool& complete) {
+    const ScopedTimer timer(StatTimer::JournalReplay);
+    MappedFile journal;
+    if (!journal.open(filename_)) {
+        return 0;
+    }
+    Stats::add(StatCounter::BytesRead, journal.size());
+
+    std::size_t uncommitted = 0;
+    const char* begin = journal.data();
+    const char* end = begin + journal.size();
+    const char* cursor = begin;
+    // Stop at the first malformed or unterminated record: it was cut short by a crash, and
+    // anything after it can't be trusted.
+    while (cursor < end) {
+        const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        if (!newline) break;
+        const std::string_view line(cursor, newline - cursor);
+        if (!applyRecord(line, courses, unnamedCounter)) break;
+        cursor = newline + 1;
+
+        if (line == "C") {
+            committedSize_ = cursor - begin;
+            committedRecords_ = records_;
+            uncommitted = 0;
+        } else if (line == "S") {
+            records_ = 0;
+        } else {
+            ++records_;
+            ++uncommitted;
+        }
+    }
+    size_ = cursor - begin;
+    complete = cursor == end;
+    return uncommitted;
+}
+
+bool Journal::openForAppend() {
+    if (!file_) {
+        file_ = std::fopen(filename_.c_str(), "ab");
+        if (!file_) {
+            std::cerr << "Error: Could not open journal: " << filename_ << std::endl;
+        }
+    }
+    return file_ != nullptr;
+}
+
+bool Journal::append(const std::string& record) {
+    if (failed_ || !openForAppend()) {
+        failed_ = true;
+        return false;
+    }
+    // Hand every record to the OS right away so it survives a crash of this process;
+    // only the (much slower) trip to the disk itself is batched.
+    const bool written = std::fwrite(record.data(), 1, record.size(), file_) == record.size()
+                         && std::fflush(file_) == 0;
+    size_ += record.size();
+    if (!written) {
+        std::cerr << "Error: Could not write to journal: " << filename_ << std::endl;
+        failed_ = true;
+        return false;
+    }
+    Stats::add(StatCounter::BytesWritten, record.size());
+    return ++unsynced_ < SYNC_BATCH || sync();
+}
+
+bool Journal::sync() {
+    unsynced_ = 0;
+    if (file_ && !syncFile(file_)) {
+        std::cerr << "Error: Could not sync journal: " << filename_ << std::endl;
+        failed_ = true;
+    }
+    return !failed_;
+}
+
+bool Journal::recordAdd(const CourseView& course) {
+    std::string record = "T\t";
+    appendCourse(record, course);
+    ++records_;
+    return append(record);
+}
+
+bool Journal::recordReplace(const std::size_t index, const CourseView& course) {
+    std::string record = "R\t" + std::to_string(index) + '\t';
+    appendCourse(record, course);
+    ++records_;
+    return append(record);
+}
+
+bool Journal::recordRemove(const std::size_t index) {
+    ++records_;
+    return append("D\t" + std::to_string(index) + '\n');
+}
+
+bool Journal::recordScheme(const GradingScheme scheme) {
+    ++records_;
+    return append("G\t" + std::string(schemeName(scheme)) + '\n');
+}
+
+bool Journal::commit() {
+    if (!hasUncommitted()) {
+        return !failed_;
+    }
+    if (!append("C\n") || !sync()) {
+        return false;
+    }
+    committedSize_ = size_;
+    committedRecords_ = records_;
+    return true;
+}
+
+void Journal::rollback() {
+    if (!hasUncommitted()) {
+        return;
+    }
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code error;
+    std::filesystem::resize_file(filename_, committedSize_, error);
+    size_ = committedSize_;
+    records_ = committedRecords_;
+    unsynced_ = 0;
+    // Everything up to the last commit was written and synced.
+    failed_ = failed_ && error;
+}
+
+bool Journal::compact(const CourseBook& courses) {
+    const std::string tempName = filename_ + ".tmp";
+    std::FILE* temp = std::fopen(tempName.c_str(), "wb");
+    if (!temp) {
+        std::cerr << "Error: Could not open journal for compaction: " << tempName << std::endl;
+        return false;
+    }
+
+    // The snapshot names its scheme, since the data file may still be on another one.
+    std::string buffer = "S\nG\t" + std::string(schemeName(courses.scheme())) + '\n';
+    for (const auto& course : courses) {
+        buffer += "T\t";
+        appendCourse(buffer, course);
+        if (buffer.size() >= IO_BUFFER_SIZE) {
+            std::fwrite(buffer.data(), 1, buffer.size(), temp);
+            buffer.clear();
+        }
+    }
+    buffer += "C\n";
+    std::fwrite(buffer.data(), 1, buffer.size(), temp);
+    const bool written = syncFile(temp) && !std::ferror(temp);
+    if (written && Stats::enabled()) {
+        Stats::add(StatCounter::BytesWritten, static_cast<std::uint64_t>(std::ftell(temp)));
+    }
+    if (std::fclose(temp) != 0 || !written) {
+        std::cerr << "Error: Could not write journal snapshot: " << tempName << std::endl;
+        std::error_code error;
+        std::filesystem::remove(tempName, error);
+        return false;
+    }
+
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempName, filename_, error);
+    if (error) {
+        std::cerr << "Error: Could not replace journal: " << filename_ << std::endl;
+        return false;
+    }
+    size_ = committedSize_ = std::filesystem::file_size(filename_, error);
+    records_ = committedRecords_ = courses.size();
+    unsynced_ = 0;
+    failed_ = false;
+    return true;
+}
+
+bool Journal::clear() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::error_code error;
+    std::filesystem::remove(filename_, error);
+    if (error) {
+        std::cerr << "Error: Could not delete journal: " << filename_ << std::endl;
+        return false;
+    }
+    size_ = committedSize_ = 0;
+    records_ = committedRecords_ = 0;
+    unsynced_ = 0;
+    failed_ = false;
+    return true;
+}
+
+bool hasJournal(const std::string& dataFile) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(dataFile + ".journal", error);
+    return !error && size > 0;
+}
+
+bool saveWithJournal(Journal& journal, const CourseBook& courses, const std::string& dataFile,
+                     const CourseFileFormat format, const int unnamedCounter, const bool rewrite) {
+    const bool committed = journal.commit();
+    if (committed && !rewrite && !journal.needsCompaction(courses.size())) {
+        return true;
+    }
+    // Make the journal self-contained first, so a crash while the data file is being
+    // rewritten still leaves a journal that restores everything.
+    const bool compacted = journal.compact(courses);
+    if (!saveCourses(courses, dataFile, format, unnamedCounter)) {
+        // The committed journal, or the snapshot that replaced it, still holds the changes.
+        return committed || compacted;
+    }
+    // A journal left next to the new data file is harmless if it is a snapshot; otherwise its
+    // records would be replayed a second time.
+    return journal.clear() || compacted;
+}
+
+std::optional<CourseFileFormat> loadWithJournal(CourseBook& courses, int& unnamedCounter, const std::string& dataFile) {
+    const auto format = loadCourses(courses, unnamedCounter, dataFile);
+    if (!format) {
+        return std::nullopt;
+    }
+    Journal journal(dataFile + ".journal");
+    journal.read(courses, unnamedCounter);
+    return format;
+}
+
+bool summarizeWithJournal(const std::string& dataFile, GpaTotals& totals) {
+    if (!hasJournal(dataFile)) {
+        return summarizeCourses(dataFile, totals);
+    }
+    CourseBook courses;
+    int unnamedCounter = 0;
+    if (!loadWithJournal(courses, unnamedCounter, dataFile)) {
+        return false;
+    }
+    totals = courses.cumulative();
+    return true;
+}
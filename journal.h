@@ -0,0 +1,118 @@
+#ifndef GPA_CALC_JOURNAL_H
+#define GPA_CALC_JOURNAL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+
+#include "course.h"
+#include "course_book.h"
+#include "storage.h"
+
+// Append-only write-ahead log of the changes made to a course book since its data file was last
+// written. Each add, edit and delete appends one short line, so saving costs O(1) instead of
+// rewriting the data file:
+//
+//   T <term> <credits> <grade> <name>          add a course
+//   R <index> <term> <credits> <grade> <name>  replace the course at a 0-based index
+//   D <index>                                  delete the course at a 0-based index
+//   S                                          start of a self-contained snapshot: clear the book
+//   G <scheme>                                 switch the book to another grading scheme
+//   C                                          commit: everything above was saved by the user
+//
+// (fields are tab-separated). Journals written before terms existed use A and E records, which
+// are T and R without the term, for courses in term 1. Records are flushed to the OS as they are written and fsynced in
+// batches, so a crash loses at most the last few changes. Records after the last commit are an
+// unsaved session; they are replayed after a crash and truncated away when the user declines to save.
+class Journal {
+public:
+    explicit Journal(std::string filename);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Applies the journal to a book freshly loaded from the data file. Returns the number of
+    // replayed records that were never committed (changes from an interrupted session). An
+    // incomplete record a crash left at the end is truncated away, so only call this on a book
+    // that is open for writing.
+    std::size_t replay(CourseBook& courses, int& unnamedCounter);
+    // Like replay(), but for readers: stops at the last complete record and never writes to the file.
+    std::size_t read(CourseBook& courses, int& unnamedCounter);
+
+    // Each returns false (after reporting the error) if the record couldn't be written. The journal
+    // then refuses further records and commits until compact(), rollback() or clear() repairs it,
+    // since a record missing from the middle would shift the indices of every one after it.
+    bool recordAdd(const CourseView& course);
+    bool recordReplace(std::size_t index, const CourseView& course);
+    bool recordRemove(std::size_t index);
+    bool recordScheme(GradingScheme scheme);
+
+    // Marks everything written so far as saved and makes it durable. Returns false if it isn't.
+    bool commit();
+    // Drops every record written since the last commit.
+    void rollback();
+    // Rewrites the journal as a committed snapshot of `courses`, atomically, so it no longer
+    // depends on the data file. After that the data file can be rewritten and the journal cleared.
+    // Returns false, leaving the journal as it was, if the snapshot couldn't be written.
+    bool compact(const CourseBook& courses);
+    // Empties the journal once the data file holds everything it contained. Returns false if the
+    // journal couldn't be deleted.
+    bool clear();
+
+    // Number of change records since the data file was last written.
+    std::size_t records() const { return records_; }
+    // True once the journal is long enough that rewriting the data file pays for itself: at
+    // least as many records as the book has courses, so compaction stays amortised O(1).
+    bool needsCompaction(const std::size_t courseCount) const {
+        return records_ >= std::max(MIN_COMPACTION_RECORDS, courseCount);
+    }
+    bool hasUncommitted() const { return size_ > committedSize_; }
+
+    static constexpr std::size_t MIN_COMPACTION_RECORDS = 1024;
+    static constexpr std::size_t SYNC_BATCH = 16;
+
+private:
+    // Applies the complete records and returns the number of uncommitted ones; `complete` is
+    // false if something after them was cut short.
+    std::size_t apply(CourseBook& courses, int& unnamedCounter, bool& complete);
+    bool openForAppend();
+    bool append(const std::string& record);
+    bool sync();
+
+    std::string filename_;
+    std::FILE* file_ = nullptr;
+    std::size_t records_ = 0;
+    std::size_t committedRecords_ = 0;
+    std::size_t unsynced_ = 0;
+    std::uintmax_t size_ = 0;
+    std::uintmax_t committedSize_ = 0;
+    // Set when a write failed, so the file may be missing records or end in a partial one.
+    bool failed_ = false;
+};
+
+// True if `dataFile` has a non-empty journal next to it, i.e. changes the data file doesn't hold
+// yet. Saving only appends to the journal, so everything that reads a data file checks this.
+bool hasJournal(const std::string& dataFile);
+
+// Loads a data file and reads its journal, giving the courses as the last session left them.
+// Neither file is written to. A journal without a data file (a book that was never compacted) is
+// read on its own. Gives std::nullopt, without replaying, if the data file can't be loaded (see
+// loadCourses()).
+std::optional<CourseFileFormat> loadWithJournal(CourseBook& courses, int& unnamedCounter, const std::string& dataFile);
+
+// Saves a session: commits the journal and, if `rewrite` is set or the journal needsCompaction(),
+// compacts it and rewrites the data file in `format`. If the commit fails, the rewrite is tried
+// instead. Returns true once the changes are durable in either file, false (after reporting the
+// error) if they aren't. Prints nothing on success.
+bool saveWithJournal(Journal& journal, const CourseBook& courses, const std::string& dataFile,
+                     CourseFileFormat format, int unnamedCounter, bool rewrite = false);
+
+// The totals of a data file including its journal: streamed by summarizeCourses() when there is
+// no journal, loaded with loadWithJournal() otherwise. Returns false if neither file exists or the
+// data file can't be read.
+bool summarizeWithJournal(const std::string& dataFile, GpaTotals& totals);
+
+#endif //GPA_CALC_JOURNAL_H
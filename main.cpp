@@ -1,94 +1,235 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <numeric>
-#include <limits>
 #include <cctype>
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
+#include <optional>
+
+#include "course.h"
+#include "course_book.h"
+#include "course_csv.h"
+#include "journal.h"
+#include "transcript.h"
+#include "text_reader.h"
+#include "storage.h"
+#include "mapped_courses.h"
+#include "batch.h"
+#include "analytics.h"
+#include "server.h"
+#include "planner.h"
+#include "stats.h"
+#include "validation.h"
+
+void deleteCourse(CourseBook& courses, Journal& journal);
+void printMenu(const CourseBook& courses);
+void pageCourses(const CourseBook& courses);
+std::size_t selectCourse(const CourseBook& courses, const char* action);
+Course getCourseDetailsFromUser(int& unnamedCounter, int defaultTerm, GradingScheme scheme);
+void addCourse(CourseBook& courses, int& unnamedCounter, Journal& journal);
+void editCourse(CourseBook& courses, int& unnamedCounter, Journal& journal);
+void planTargetGPA(const CourseBook& courses);
+void viewTerms(const CourseBook& courses);
+bool saveProgress(const CourseBook& courses, int unnamedCounter, Journal& journal, const std::string& filename,
+                  CourseFileFormat format, bool rewrite);
+int exportCourses(const std::string& dataFile, const std::string& filename);
+int importCourses(const std::string& dataFile, const std::string& filename, std::optional<GradingScheme> scheme,
+                  bool saveBinary);
+
+void printUsage(const char* program);
+std::string readInput();
+
+constexpr std::size_t PAGE_SIZE = 20;
+
+int main(int argc, char* argv[]) {
+    std::string batchFile;
+    std::string analyticsFile;
+    std::string summaryFile;
+    std::string reportFile;
+    std::string exportFile;
+    std::string importFile;
+    std::string outputFile;
+    std::string socketPath;
+    bool saveBinary = false;
+    unsigned threads = 0;
+    std::size_t top = 10;
+    std::optional<GradingScheme> scheme;
+    Stats::enableFromEnvironment();
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        StatsFormat statsFormat;
+        if (arg == "--batch" && i + 1 < argc) {
+            batchFile = argv[++i];
+        } else if (arg == "--analytics" && i + 1 < argc) {
+            analyticsFile = argv[++i];
+        } else if (arg == "--scheme" && i + 1 < argc && (scheme = parseScheme(argv[i + 1]))) {
+            ++i;
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = static_cast<std::size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--binary") {
+            saveBinary = true;
+        } else if (arg == "--report" && i + 1 < argc) {
+            reportFile = argv[++i];
+        } else if (arg == "--export" && i + 1 < argc) {
+            exportFile = argv[++i];
+        } else if (arg == "--import" && i + 1 < argc) {
+            importFile = argv[++i];
+        } else if (arg == "--summary" && i + 1 < argc) {
+            summaryFile = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if ((arg == "--stats" || arg.starts_with("--stats="))
+                   && Stats::parseFormat(std::string_view(arg).substr(std::min<std::size_t>(arg.size(), 8)), statsFormat)) {
+            Stats::enable(statsFormat);
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (!socketPath.empty()) {
+        return runServer(socketPath);
+    }
+    if (!batchFile.empty()) {
+        return runBatch(batchFile, outputFile, threads, scheme.value_or(GradingScheme::Fcai));
+    }
+    if (!analyticsFile.empty()) {
+        return runAnalytics(analyticsFile, outputFile, threads, top, scheme.value_or(GradingScheme::Fcai));
+    }
+    if (!reportFile.empty() && hasJournal(reportFile)) {
+        // Changes saved since the file was last written are only in its journal.
+        CourseBook courses;
+        int unnamedCounter = 0;
+        if (!loadWithJournal(courses, unnamedCounter, reportFile)) {
+            return 1;
+        }
+        viewCourses(courses);
+        std::cout.precision(3);
+        std::cout << "Current GPA: " << calculateGPA(courses) << "\n";
+        std::cout << "Total completed hours: " << totalHours(courses) << "\n";
+        return 0;
+    }
+    if (!reportFile.empty()) {
+        MappedCourses archive;
+        if (!archive.open(reportFile)) {
+            std::cerr << "Error: Could not open binary data file: " << reportFile << std::endl;
+            return 1;
+        }
+        viewCourses(archive);
+        // Retaken courses count by their latest attempt, as in the menu. The names are borrowed
+        // from the mapping, so only a table of the distinct names is built.
+        LatestAttempts latest(true);
+        for (const CourseView course : archive) {
+            latest.add(course, archive.scheme());
+        }
+        std::cout.precision(3);
+        std::cout << "Current GPA: " << latest.totals().gpa() << "\n";
+        std::cout << "Total completed hours: " << latest.totals().credits << "\n";
+        return 0;
+    }
+    if (!summaryFile.empty()) {
+        GpaTotals totals;
+        if (!summarizeWithJournal(summaryFile, totals)) {
+            std::cerr << "Error: Could not open data file: " << summaryFile << std::endl;
+            return 1;
+        }
+        std::cout.precision(3);
+        std::cout << "Current GPA: " << totals.gpa() << "\n";
+        std::cout << "Total completed hours: " << totals.credits << "\n";
+        return 0;
+    }
 
+    const std::string FILENAME = "gpa_data.txt";
+    if (!exportFile.empty()) {
+        return exportCourses(FILENAME, exportFile);
+    }
+    if (!importFile.empty()) {
+        return importCourses(FILENAME, importFile, scheme, saveBinary);
+    }
 
-const std::unordered_map<std::string, double> POINTS_MAP = {
-    {"A+", 4.0}, {"A", 3.7}, {"A-", 3.4}, {"B+", 3.2}, {"B", 3.0}, {"B-", 2.8},
-    {"C+", 2.6}, {"C", 2.4}, {"C-", 2.2}, {"D+", 2.0}, {"D", 1.5}, {"D-", 1.0}, {"F", 0.0}
-};
-
-const std::unordered_map<double, std::string> GRADE_MAP = {
-    {4.0, "A+"}, {3.7, "A"}, {3.4, "A-"}, {3.2, "B+"}, {3.0, "B"}, {2.8, "B-"},
-    {2.6, "C+"}, {2.4, "C"}, {2.2, "C-"}, {2.0, "D+"}, {1.5, "D"}, {1.0, "D-"}, {0.0, "F"}
-};
-
-struct Course {
-    std::string name;
-    int credits;
-    double points;
-};
-
-void deleteCourse(std::vector<Course>& courses);
-void saveCourses(const std::vector<Course>& courses, const std::string& filename);
-void loadCourses(std::vector<Course>& courses, int& unnamedCounter, const std::string& filename);
-void printMenu(const std::vector<Course>& courses);
-Course getCourseDetailsFromUser(int& unnamedCounter);
-void addCourse(std::vector<Course>& courses, int& unnamedCounter);
-void viewCourses(const std::vector<Course>& courses);
-void editCourse(std::vector<Course>& courses, int& unnamedCounter);
-double calculateGPA(const std::vector<Course>& courses);
-int totalHours(const std::vector<Course>& courses);
-
-int main() {
-    std::vector<Course> courses;
+    CourseBook courses;
     int unnamedCoursesCounter = 0;
     int option;
-    const std::string FILENAME = "gpa_data.txt";
 
-    loadCourses(courses, unnamedCoursesCounter, FILENAME);
+    const auto loaded = loadCourses(courses, unnamedCoursesCounter, FILENAME);
+    if (!loaded) {
+        // Saving what was read would overwrite the rest of the file.
+        return 1;
+    }
+    CourseFileFormat format = *loaded;
+    bool convertFormat = saveBinary && format != CourseFileFormat::Binary;
+    if (saveBinary) {
+        format = CourseFileFormat::Binary;
+    }
+    Journal journal(FILENAME + ".journal");
+    if (const std::size_t recovered = journal.replay(courses, unnamedCoursesCounter)) {
+        std::cout << "Recovered " << recovered << " unsaved change(s) from an interrupted session.\n";
+    }
+    // Converted after the replay, which reads the journal on the scheme it was written with.
+    if (scheme && *scheme != courses.scheme()) {
+        if (!courses.setScheme(*scheme)) {
+            std::cerr << "Error: Some grades in " << FILENAME << " are not on the " << schemeName(*scheme)
+                      << " scale." << std::endl;
+            return 1;
+        }
+        journal.recordScheme(*scheme);
+        convertFormat = true;
+    }
 
     while (true) {
         printMenu(courses);
         std::cout << "Enter your choice: ";
-        std::cin >> option;
-
-        if (std::cin.fail()) {
+        if (!parseNumber(readInput(), option)) {
             std::cout << "Invalid input. Please enter a number.\n";
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             continue;
         }
+        Stats::add(StatCounter::MenuActions);
 
         switch (option) {
             case 1:
-                addCourse(courses, unnamedCoursesCounter);
+                addCourse(courses, unnamedCoursesCounter, journal);
                 break;
             case 2:
-                viewCourses(courses);
+                pageCourses(courses);
                 break;
             case 3:
                 if (!courses.empty()) {
-                    editCourse(courses, unnamedCoursesCounter);
+                    editCourse(courses, unnamedCoursesCounter, journal);
                 } else {
                     std::cout << "No courses to edit.\n";
                 }
                 break;
             case 4:
                 if (!courses.empty()) {
-                    deleteCourse(courses);
+                    deleteCourse(courses, journal);
                 } else {
                     std::cout << "No courses to delete.\n";
                 }
                 break;
             case 5:
+                planTargetGPA(courses);
+                break;
+            case 6:
+                viewTerms(courses);
+                break;
+            case 7:
                 while (true) {
                     std::cout << "Do you want to save your progress? (Yes | No)\n";
-                    std::string response;
-                    std::cin >> response;
+                    std::string response(trim(readInput()));
                     for (auto& c : response) { c = tolower(c); }
                     if (response == "yes" || response == "no") {
                         if (response == "yes") {
-                            saveCourses(courses, FILENAME);
+                            const bool saved = saveProgress(courses, unnamedCoursesCounter, journal, FILENAME, format,
+                                                            convertFormat);
                             std::cout << "Exiting. Goodbye!\n";
-                            return 0;
+                            return saved ? 0 : 1;
                         }
                         else {
+                            journal.rollback();
                             std::cout << "Exiting. Goodbye!\n";
                             return 0;
                         }
@@ -103,76 +244,15 @@ int main() {
     }
 }
 
-void deleteCourse(std::vector<Course>& courses) {
-    viewCourses(courses);
-    int choice = 0;
-
-    while (true) {
-        std::cout << "Enter the number of the course to edit: ";
-        std::cin >> choice;
-        if (!std::cin.fail() && choice > 0 && choice <= courses.size()) {
-            break;
-        }
-        std::cout << "Invalid number.\n";
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    }
-
-    courses.erase(courses.begin() + --choice);
-    std::cout << "Course updated deleted!\n";
-}
-
-void saveCourses(const std::vector<Course>& courses, const std::string& filename) {
-    std::ofstream outFile(filename);
-    if (!outFile.is_open()) {
-        std::cerr << "Error: Could not open file for saving: " << filename << std::endl;
-        return;
-    }
-
-    for (const auto& course : courses) {
-        outFile << course.name << '\n';
-        outFile << course.credits << '\n';
-        outFile << course.points << '\n';
-    }
-    outFile.close();
-    std::cout << "Progress saved successfully.\n";
-}
-
-void loadCourses(std::vector<Course>& courses, int& unnamedCounter, const std::string& filename) {
-    std::ifstream inFile(filename);
-    if (!inFile.is_open()) {
-        return;
-    }
-
-    std::string line;
-    while (std::getline(inFile, line)) {
-        Course course;
-        course.name = line;
-
-        if (std::getline(inFile, line)) {
-            try { course.credits = std::stoi(line); }
-            catch (const std::exception& e) { continue;}
-        } else break;
-
-        if (std::getline(inFile, line)) {
-            try { course.points = std::stod(line); }
-            catch (const std::exception& e) { continue;}
-        } else break;
-
-        if (course.name.rfind("Unnamed Course ", 0) == 0) {
-            try {
-                int num = std::stoi(course.name.substr(15));
-                if (num > unnamedCounter) {
-                    unnamedCounter = num;
-                }
-            } catch (const std::exception& e) {}
-        }
-        courses.push_back(course);
-    }
-    inFile.close();
+void deleteCourse(CourseBook& courses, Journal& journal) {
+    const std::size_t position = selectCourse(courses, "delete");
+    courses.remove(position);
+    journal.recordRemove(position);
+    std::cout << "Course deleted successfully!\n";
 }
 
-void printMenu(const std::vector<Course>& courses) {
+void printMenu(const CourseBook& courses) {
+    const ScopedTimer timer(StatTimer::MenuRender);
     std::cout << "==============================================" << std::endl;
     std::cout << "================GPA Calculator================" << std::endl;
     std::cout << "==============================================" << std::endl;
@@ -188,104 +268,305 @@ void printMenu(const std::vector<Course>& courses) {
     std::cout << "2. View Courses" << std::endl;
     std::cout << "3. Edit Courses" << std::endl;
     std::cout << "4. Delete a Course" << std::endl;
-    std::cout << "5. Exit" << std::endl;
+    std::cout << "5. Plan for a Target GPA" << std::endl;
+    std::cout << "6. View GPA by Term" << std::endl;
+    std::cout << "7. Exit" << std::endl;
 }
 
-Course getCourseDetailsFromUser(int& unnamedCounter) {
+Course getCourseDetailsFromUser(int& unnamedCounter, const int defaultTerm, const GradingScheme scheme) {
     Course course;
     std::string tempString;
 
     std::cout << "Course Name (Optional): ";
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::getline(std::cin, course.name);
-    if (course.name == "0" || course.name.empty()) {
-        course.name = "Unnamed Course " + std::to_string(++unnamedCounter);
+    course.name = courseNameOrDefault(readInput(), unnamedCounter);
+
+    while (true) {
+        std::cout << "Course Term (1-" << MAX_TERM << ", Enter for term " << defaultTerm << "): ";
+        tempString = readInput();
+        if (trim(tempString).empty()) {
+            course.term = defaultTerm;
+            break;
+        }
+        if (checkTerm(tempString, course.term) == InputError::None) break;
+        std::cout << "Invalid input. Please enter a term number from 1 to " << MAX_TERM << ".\n";
     }
 
     while (true) {
         std::cout << "Course Credits (0-9): ";
-        std::cin >> course.credits;
-        if (!std::cin.fail() && course.credits >= 0 && course.credits < 10) break;
-
+        if (checkCredits(readInput(), course.credits) == InputError::None) break;
         std::cout << "Invalid input. Please enter a single digit number.\n";
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
 
     while (true) {
         std::cout << "Course Grade (e.g., A+, B, C-): ";
-        std::cin >> tempString;
-        for (auto& c : tempString) { c = toupper(c); }
-
-        if (POINTS_MAP.contains(tempString)) {
-            course.points = POINTS_MAP.at(tempString);
-            break;
+        const InputError error = checkGrade(readInput(), scheme, course.grade);
+        if (error == InputError::None) break;
+        if (error == InputError::GradeOffScale) {
+            std::cout << "That grade is not on the " << schemeName(scheme) << " scale. Please use another grade.\n";
+        } else {
+            std::cout << "Invalid grade entered. Please use a grade on the " << schemeName(scheme) << " scale.\n";
         }
-        std::cout << "Invalid grade entered. Please use a valid grade.\n";
     }
 
     return course;
 }
 
-void addCourse(std::vector<Course>& courses, int& unnamedCounter) {
-    courses.push_back(getCourseDetailsFromUser(unnamedCounter));
+void addCourse(CourseBook& courses, int& unnamedCounter, Journal& journal) {
+    courses.add(getCourseDetailsFromUser(unnamedCounter, std::max(1, courses.terms().lastTerm()), courses.scheme()));
+    journal.recordAdd(courses[courses.size() - 1]);
     std::cout << "Course added successfully!\n";
 }
 
-void viewCourses(const std::vector<Course>& courses) {
-    if (courses.empty()) {
-        std::cout << "No courses to display.\n";
+void pageCourses(const CourseBook& courses) {
+    if (courses.size() <= PAGE_SIZE) {
+        viewCourses(courses);
         return;
     }
-    int i = 0;
-    for (const auto& course : courses) {
-        std::cout << "----------------------------------------\n";
-        std::cout << ++i << ".\n";
-        std::cout << "   Course Name:   " << course.name << "\n";
-        std::cout << "   Course Credits: " << course.credits << "\n";
-        std::cout << "   Course Grade:   " << GRADE_MAP.at(course.points) << "\n";
+
+    for (std::size_t first = 0; first < courses.size(); first += PAGE_SIZE) {
+        viewCourses(courses, first, PAGE_SIZE);
+        if (first + PAGE_SIZE >= courses.size()) {
+            break;
+        }
+        std::cout << "Showing " << first + PAGE_SIZE << " of " << courses.size()
+                  << " courses. Press Enter for more or q to stop: ";
+        std::string response;
+        if (!std::getline(std::cin, response) || (!response.empty() && tolower(response[0]) == 'q')) {
+            break;
+        }
     }
-    std::cout << "----------------------------------------\n";
 }
 
-void editCourse(std::vector<Course>& courses, int& unnamedCounter) {
-    viewCourses(courses);
-    int choice = 0;
+std::size_t selectCourse(const CourseBook& courses, const char* action) {
+    // Short lists are shown up front; long ones are searched by name instead of printed.
+    if (courses.size() <= PAGE_SIZE) {
+        viewCourses(courses);
+    }
+
     while (true) {
-        std::cout << "Enter the number of the course to edit: ";
-        std::cin >> choice;
-        if (!std::cin.fail() && choice > 0 && choice <= courses.size()) {
-            break;
+        std::cout << "Enter the number or name of the course to " << action << ": ";
+        const std::string input = readInput();
+        const std::string_view query = trim(input);
+
+        std::size_t number = 0;
+        if (parseNumber(query, number)) {
+            if (number > 0 && number <= courses.size()) {
+                return number - 1;
+            }
+            std::cout << "Invalid number.\n";
+            continue;
+        }
+
+        std::vector<std::size_t> matches = courses.findByName(query);
+        if (matches.empty()) {
+            matches = courses.findByPrefix(query, PAGE_SIZE);
+        }
+        if (matches.size() == 1) {
+            return matches.front();
+        }
+        if (matches.empty()) {
+            std::cout << "No course is named \"" << query << "\".\n";
+            continue;
+        }
+        std::cout << "Several courses match; enter the number of the one you mean:\n";
+        for (const std::size_t position : matches) {
+            std::cout << "   " << position + 1 << ". " << courses[position].name << "\n";
         }
-        std::cout << "Invalid number.\n";
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
+}
 
-    courses[choice - 1] = getCourseDetailsFromUser(unnamedCounter);
+void editCourse(CourseBook& courses, int& unnamedCounter, Journal& journal) {
+    const std::size_t position = selectCourse(courses, "edit");
+    courses.replace(position, getCourseDetailsFromUser(unnamedCounter, courses[position].term, courses.scheme()));
+    journal.recordReplace(position, courses[position]);
     std::cout << "Course updated successfully!\n";
 }
 
-double calculateGPA(const std::vector<Course>& courses) {
+void planTargetGPA(const CourseBook& courses) {
+    const GradingScheme scheme = courses.scheme();
+    const Grade top = topGrade(scheme);
+    double target;
+    while (true) {
+        std::cout << "Target GPA (0-" << gradePoints(top, scheme) << "): ";
+        const std::string input = readInput();
+        if (parseNumber(input, target) && target >= 0.0 && target <= gradePoints(top, scheme)) break;
+        std::cout << "Invalid input. Please enter a number from 0 to " << gradePoints(top, scheme) << ".\n";
+    }
+
+    std::vector<int> plannedCredits;
+    while (true) {
+        std::cout << "Credits of each remaining course, separated by spaces (e.g., 3 3 2): ";
+        const std::string input = readInput();
+        plannedCredits.clear();
+        bool valid = true;
+        std::string_view rest = input;
+        while (!(rest = trim(rest)).empty()) {
+            const std::string_view field = rest.substr(0, rest.find(' '));
+            int credits = 0;
+            valid = valid && checkCredits(field, credits) == InputError::None;
+            plannedCredits.push_back(credits);
+            rest.remove_prefix(field.size());
+        }
+        if (valid && !plannedCredits.empty()) break;
+        std::cout << "Invalid input. Please enter single digit numbers.\n";
+    }
+
+    const GpaTotals current = courses.cumulative();
+    const auto plan = planGrades(current, plannedCredits, target, scheme);
+    std::cout.precision(3);
+    if (!plan) {
+        GpaTotals best = current;
+        for (const int credits : plannedCredits) {
+            best.add(credits, top, scheme);
+        }
+        std::cout << "A GPA of " << target << " is out of reach: an " << gradeLetter(top)
+                  << " in every remaining course gives " << best.gpa() << ".\n";
+        return;
+    }
+
+    std::cout << "Lowest grade needed in every remaining course: "
+              << gradeLetter(*lowestUniformGrade(current, plannedCredits, target, scheme)) << "\n";
+    std::cout << "Least demanding plan:\n";
+    for (std::size_t i = 0; i < plannedCredits.size(); ++i) {
+        std::cout << "   Course " << i + 1 << " (" << plannedCredits[i] << " credits): "
+                  << gradeLetter(plan->grades[i]) << "\n";
+    }
+    std::cout << "GPA with this plan: " << plan->totals.gpa() << "\n";
+}
+
+void viewTerms(const CourseBook& courses) {
     if (courses.empty()) {
-        return 0.0;
+        std::cout << "No courses to display.\n";
+        return;
+    }
+    const TermTotals& terms = courses.terms();
+    std::cout.precision(3);
+    for (int term = 1; term <= terms.lastTerm(); ++term) {
+        if (terms.courses(term) == 0) {
+            continue;
+        }
+        const GpaTotals cumulative = terms.cumulative(term);
+        std::cout << "Term " << term << ": GPA " << terms.term(term).gpa() << " (" << terms.term(term).credits
+                  << " hours) | Cumulative GPA " << cumulative.gpa() << " (" << cumulative.credits << " hours)\n";
+    }
+    std::cout << "Retaken courses count only by their latest attempt in the cumulative GPA.\n";
+}
+
+bool saveProgress(const CourseBook& courses, const int unnamedCounter, Journal& journal, const std::string& filename,
+                  const CourseFileFormat format, const bool rewrite) {
+    if (!saveWithJournal(journal, courses, filename, format, unnamedCounter, rewrite)) {
+        std::cerr << "Error: Your progress could not be saved." << std::endl;
+        return false;
+    }
+    std::cout << "Progress saved successfully.\n";
+    return true;
+}
+
+int exportCourses(const std::string& dataFile, const std::string& filename) {
+    CourseBook courses;
+    int unnamedCounter = 0;
+    if (!loadWithJournal(courses, unnamedCounter, dataFile)) {
+        return 1;
+    }
+
+    const bool saved = isCsvFile(filename) ? saveCoursesCsv(courses, filename)
+                                           : saveCourses(courses, filename, CourseFileFormat::Binary, unnamedCounter);
+    if (!saved) {
+        return 1;
+    }
+    std::cout << "Exported " << courses.size() << " course(s) to " << filename << "\n";
+    return 0;
+}
+
+int importCourses(const std::string& dataFile, const std::string& filename, const std::optional<GradingScheme> scheme,
+                  const bool saveBinary) {
+    // The data file keeps its format unless --binary says otherwise, and CSV imports are graded on
+    // its scheme unless --scheme picks another. The header is read either way, for the scheme.
+    CourseFileHeader header;
+    const CourseFileFormat format = readFileHeader(dataFile, header) == CourseFileFormat::Binary || saveBinary
+                                        ? CourseFileFormat::Binary
+                                        : CourseFileFormat::Text;
+    GradingScheme dataScheme = header.scheme;
+    if (hasJournal(dataFile)) {
+        // A scheme switch that hasn't been compacted yet is only in the journal.
+        CourseBook current;
+        int currentCounter = 0;
+        if (!loadWithJournal(current, currentCounter, dataFile)) {
+            return 1;
+        }
+        dataScheme = current.scheme();
     }
 
-    double totalPoints = std::accumulate(courses.begin(), courses.end(), 0.0,
-        [] (const double sum, const Course& course) {
-            return course.points * course.credits + sum;
-        });;
-    int totalCredits = std::accumulate(courses.begin(), courses.end(), 0,
-        [] (const int sum, const Course& course) {
-            return sum + course.credits;
-        });
+    CourseBook courses;
+    int unnamedCounter = 0;
+    std::size_t rejected = 0;
+    if (isCsvFile(filename)) {
+        courses.setScheme(scheme.value_or(dataScheme));
+        if (!loadCoursesCsv(courses, unnamedCounter, filename, rejected)) {
+            return 1;
+        }
+    } else {
+        if (!std::ifstream(filename) && !hasJournal(filename)) {
+            std::cerr << "Error: Could not open data file: " << filename << std::endl;
+            return 1;
+        }
+        if (!loadWithJournal(courses, unnamedCounter, filename)) {
+            return 1;
+        }
+        if (scheme && !courses.setScheme(*scheme)) {
+            std::cerr << "Error: Some grades in " << filename << " are not on the " << schemeName(*scheme)
+                      << " scale." << std::endl;
+            return 1;
+        }
+    }
 
-    return totalCredits == 0 ? 0.0 : totalPoints / totalCredits;
+    // Same order as a compacting save: a crash at any point leaves either the old courses or the new ones.
+    Journal journal(dataFile + ".journal");
+    const bool compacted = journal.compact(courses);
+    if (!saveCourses(courses, dataFile, format, unnamedCounter) || (!journal.clear() && !compacted)) {
+        return 1;
+    }
+    std::cout << "Imported " << courses.size() << " course(s) from " << filename;
+    if (rejected > 0) {
+        std::cout << ", skipping " << rejected << " malformed record(s)";
+    }
+    std::cout << "\n";
+    return 0;
 }
 
-int totalHours(const std::vector<Course>& courses) {
-    return std::accumulate(courses.begin(), courses.end(), 0,
-        [](const int sum, const Course& course) {
-            return sum + course.credits;
-        });
-}
\ No newline at end of file
+std::string readInput() {
+    std::string line;
+    if (!std::getline(std::cin, line)) {
+        // Nobody is left to answer, so leave without saving. Changes stay in the journal as an
+        // unsaved session and are offered again on the next start.
+        std::cout << "\nEnd of input. Exiting without saving.\n";
+        std::exit(1);
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    return line;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--binary | --batch <roster> [--output <file>] [--threads <n>] | --analytics <roster> [--top <n>] [--output <file>] [--threads <n>] | --export <file> | --import <file> | --summary <file> | --report <file> | --serve <socket>] [--scheme <name>] [--stats[=json]]\n";
+    std::cout << "  (no arguments)      Start the interactive GPA calculator\n";
+    std::cout << "  --binary            Save gpa_data.txt in the compact binary format on exit\n";
+    std::cout << "  --batch <roster>    Compute GPA and hours for every student in a roster file\n";
+    std::cout << "                      with one \"student,course name,credits,grade\" row per line\n";
+    std::cout << "  --analytics <roster>\n";
+    std::cout << "                      Report the cohort GPA, GPA percentiles, top students and grade\n";
+    std::cout << "                      distribution overall and per course of a roster file\n";
+    std::cout << "  --top <n>           Rank the <n> best students in the analytics report (default: 10)\n";
+    std::cout << "  --output <file>     Write batch or analytics results to <file> instead of standard output\n";
+    std::cout << "  --threads <n>       Use <n> worker threads for batch and analytics mode (default: all cores)\n";
+    std::cout << "  --scheme <name>     Grade rosters, or regrade gpa_data.txt, on the fcai (default),\n";
+    std::cout << "                      fcai-old or us43 scale; data files remember their scheme\n";
+    std::cout << "  --export <file>     Write the courses in gpa_data.txt to <file>: CSV if it ends in .csv,\n";
+    std::cout << "                      the columnar binary format otherwise\n";
+    std::cout << "  --import <file>     Replace the courses in gpa_data.txt with those of a CSV or data file\n";
+    std::cout << "  --summary <file>    Print the GPA and total hours of a data file without loading it\n";
+    std::cout << "  --report <file>     List the courses, GPA and hours of a binary data file read-only\n";
+    std::cout << "  --serve <socket>    Keep data files in the current directory loaded and answer\n";
+    std::cout << "                      GPA, add, edit and delete requests on a Unix domain socket\n";
+    std::cout << "  --stats[=json]      Print timings, I/O and allocation counts to standard error on exit\n";
+    std::cout << "                      (also enabled by setting GPA_CALC_STATS=1 or GPA_CALC_STATS=json)\n";
+}
@@ -0,0 +1,64 @@
+#include "mapped_courses.h"
+
+#include <cstring>
+
+#include "stats.h"
+#include "storage.h"
+
+bool MappedCourses::open(const std::string& filename) {
+    *this = MappedCourses();
+    if (!file_.open(filename)) {
+        return false;
+    }
+
+    BinaryHeader header;
+    if (!readBinaryHeader(file_.data(), file_.size(), header)) {
+        file_.close();
+        return false;
+    }
+
+    count_ = header.courseCount;
+    namesSize_ = header.namesSize;
+    offsets_ = file_.data() + binaryHeaderSize(header.version);
+    names_ = offsets_ + (count_ + 1) * sizeof(std::uint64_t);
+    credits_ = reinterpret_cast<const unsigned char*>(names_ + namesSize_);
+    grades_ = credits_ + count_;
+    terms_ = header.version >= 3 ? grades_ + count_ : nullptr;
+    scheme_ = static_cast<GradingScheme>(header.scheme);
+    return true;
+}
+
+CourseView MappedCourses::operator[](const std::size_t index) const {
+    std::uint64_t begin;
+    std::uint64_t end;
+    std::memcpy(&begin, offsets_ + index * sizeof(begin), sizeof(begin));
+    std::memcpy(&end, offsets_ + (index + 1) * sizeof(end), sizeof(end));
+    // Offsets aren't validated on open (that would touch the whole file), so clamp them here.
+    if (end > namesSize_ || begin > end) {
+        begin = end = 0;
+    }
+    const int term = terms_ && validTerm(terms_[index]) ? terms_[index] : 1;
+    return {std::string_view(names_ + begin, end - begin), credits_[index], gradeFromCode(grades_[index], scheme_), term};
+}
+
+double allAttemptsGPA(const MappedCourses& courses) {
+    const ScopedTimer timer(StatTimer::CalculateGPA);
+    GpaTotals totals;
+    const unsigned char* credits = courses.credits();
+    const unsigned char* grades = courses.grades();
+    withScheme(courses.scheme(), [&](auto scheme) {
+        for (std::size_t i = 0; i < courses.size(); ++i) {
+            totals.add<decltype(scheme)::value>(credits[i], gradeFromCode(grades[i], scheme));
+        }
+    });
+    return totals.gpa();
+}
+
+int allAttemptsHours(const MappedCourses& courses) {
+    int hours = 0;
+    const unsigned char* credits = courses.credits();
+    for (std::size_t i = 0; i < courses.size(); ++i) {
+        hours += credits[i];
+    }
+    return hours;
+}
@@ -0,0 +1,60 @@
+#ifndef GPA_CALC_MAPPED_COURSES_H
+#define GPA_CALC_MAPPED_COURSES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "course.h"
+#include "mapped_file.h"
+
+// Read-only, zero-copy access to a binary data file. Courses are handed out as CourseViews whose
+// names point straight into the mapped file, so nothing is parsed or allocated up front and
+// opening a file costs the same regardless of its size. Views stay valid while this object lives.
+class MappedCourses {
+public:
+    class Iterator {
+    public:
+        Iterator(const MappedCourses* courses, std::size_t index) : courses_(courses), index_(index) {}
+        CourseView operator*() const { return (*courses_)[index_]; }
+        Iterator& operator++() { ++index_; return *this; }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+
+    private:
+        const MappedCourses* courses_;
+        std::size_t index_;
+    };
+
+    // Opens a binary data file; fails for missing, text-format or corrupt files.
+    bool open(const std::string& filename);
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    CourseView operator[](std::size_t index) const;
+    Iterator begin() const { return {this, 0}; }
+    Iterator end() const { return {this, count_}; }
+
+    // Contiguous per-course columns, for passes that don't need names.
+    const unsigned char* credits() const { return credits_; }
+    const unsigned char* grades() const { return grades_; }
+    // Null for files written before terms were stored (every course is in term 1).
+    const unsigned char* terms() const { return terms_; }
+    GradingScheme scheme() const { return scheme_; }
+
+private:
+    MappedFile file_;
+    std::size_t count_ = 0;
+    std::uint64_t namesSize_ = 0;
+    const char* offsets_ = nullptr;
+    const char* names_ = nullptr;
+    const unsigned char* credits_ = nullptr;
+    const unsigned char* grades_ = nullptr;
+    const unsigned char* terms_ = nullptr;
+    GradingScheme scheme_ = GradingScheme::Fcai;
+};
+
+// Over every row, retakes included; LatestAttempts applies the retake rule.
+double allAttemptsGPA(const MappedCourses& courses);
+int allAttemptsHours(const MappedCourses& courses);
+
+#endif //GPA_CALC_MAPPED_COURSES_H
@@ -0,0 +1,86 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GPA_CALC_HAVE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#ifdef GPA_CALC_HAVE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(address);
+        mapped_ = true;
+    }
+    // The mapping keeps the file's pages reachable on its own.
+    ::close(fd);
+    return true;
+#else
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+    if (!inFile.is_open()) {
+        return false;
+    }
+    buffer_.resize(static_cast<std::size_t>(inFile.tellg()));
+    inFile.seekg(0);
+    if (!inFile.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) {
+        buffer_.clear();
+        return false;
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef GPA_CALC_HAVE_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
@@ -0,0 +1,32 @@
+#ifndef GPA_CALC_MAPPED_FILE_H
+#define GPA_CALC_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped, so opening costs
+// the same regardless of size and pages are only read when touched; elsewhere it is read into memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;
+};
+
+#endif //GPA_CALC_MAPPED_FILE_H
@@ -0,0 +1,121 @@
+#include "planner.h"
+
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+namespace {
+
+constexpr int LOWEST_CODE = GRADE_COUNT - 1;
+constexpr std::uint8_t UNREACHED = UINT8_MAX;
+
+// Weighted tenths of a point the planned courses must add up to for the GPA to reach `target`;
+// zero or less if the completed courses already get there with no points from the plan.
+long long neededTenths(const GpaTotals& current, const int plannedCredits, const double target) {
+    const int credits = current.credits + plannedCredits;
+    return static_cast<long long>(std::ceil(target * 10 * credits - 1e-6)) - current.pointTenths;
+}
+
+// For each planned course and each reachable total of tenths, the grade code that first reached
+// it: row i, column s holds the grade of course i - 1 in some plan whose first i courses add up
+// to s. Only grades on the scale that are no better than `topCode` are used.
+std::vector<std::uint8_t> reachableTotals(const std::vector<int>& credits, const int limit, const int topCode,
+                                          const GradeScale& scale) {
+    const std::size_t width = static_cast<std::size_t>(limit) + 1;
+    std::vector<std::uint8_t> table((credits.size() + 1) * width, UNREACHED);
+    table[0] = 0;
+    for (std::size_t course = 0; course < credits.size(); ++course) {
+        const std::uint8_t* from = &table[course * width];
+        std::uint8_t* to = &table[(course + 1) * width];
+        for (int sum = 0; sum <= limit; ++sum) {
+            if (from[sum] == UNREACHED) continue;
+            // Lowest grades first, so a course with zero credits is planned as an F.
+            for (int code = LOWEST_CODE; code >= topCode; --code) {
+                if (scale.tenths[code] == OFF_SCALE) continue;
+                const int next = sum + credits[course] * scale.tenths[code];
+                if (next <= limit && to[next] == UNREACHED) {
+                    to[next] = static_cast<std::uint8_t>(code);
+                }
+            }
+        }
+    }
+    return table;
+}
+
+GradePlan makePlan(const GpaTotals& current, const std::vector<int>& credits, std::vector<Grade> grades,
+                   const GradingScheme scheme) {
+    GradePlan plan {std::move(grades), current};
+    for (std::size_t course = 0; course < credits.size(); ++course) {
+        plan.totals.add(credits[course], plan.grades[course], scheme);
+    }
+    return plan;
+}
+
+} // namespace
+
+std::optional<Grade> lowestUniformGrade(const GpaTotals& current, const std::vector<int>& plannedCredits,
+                                        const double target, const GradingScheme scheme) {
+    const GradeScale& scale = GRADE_SCALES[static_cast<std::size_t>(scheme)];
+    const int credits = std::accumulate(plannedCredits.begin(), plannedCredits.end(), 0);
+    if (current.credits + credits == 0 && target > 0) {
+        return std::nullopt;
+    }
+    const long long needed = neededTenths(current, credits, target);
+    for (int code = LOWEST_CODE; code >= 0; --code) {
+        if (scale.tenths[code] != OFF_SCALE && static_cast<long long>(credits) * scale.tenths[code] >= needed) {
+            return static_cast<Grade>(code);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<GradePlan> planGrades(const GpaTotals& current, const std::vector<int>& plannedCredits,
+                                    const double target, const GradingScheme scheme) {
+    const GradeScale& scale = GRADE_SCALES[static_cast<std::size_t>(scheme)];
+    const int credits = std::accumulate(plannedCredits.begin(), plannedCredits.end(), 0);
+    // With no credits at all the GPA is 0, whatever the grades.
+    if (current.credits + credits == 0 && target > 0) {
+        return std::nullopt;
+    }
+    const long long needed = neededTenths(current, credits, target);
+    const int limit = credits * gradeTenths(topGrade(scheme), scheme);
+    if (needed > limit) {
+        return std::nullopt;
+    }
+    if (needed <= 0) {
+        return makePlan(current, plannedCredits, std::vector<Grade>(plannedCredits.size(), Grade::F), scheme);
+    }
+
+    // The smallest reachable total that meets the target, using every grade.
+    const std::size_t width = static_cast<std::size_t>(limit) + 1;
+    const std::size_t lastRow = plannedCredits.size() * width;
+    std::vector<std::uint8_t> table = reachableTotals(plannedCredits, limit, 0, scale);
+    int best = static_cast<int>(needed);
+    while (table[lastRow + best] == UNREACHED) {
+        ++best;
+    }
+
+    // Then the lowest top grade that still reaches exactly that total. Allowing a better top grade
+    // only adds totals, so binary search it; grade 0 (every grade on the scale) is known to work.
+    int worksCode = 0;
+    int failsCode = GRADE_COUNT;
+    while (failsCode - worksCode > 1) {
+        const int topCode = (worksCode + failsCode) / 2;
+        std::vector<std::uint8_t> capped = reachableTotals(plannedCredits, limit, topCode, scale);
+        if (capped[lastRow + best] != UNREACHED) {
+            worksCode = topCode;
+            table = std::move(capped);
+        } else {
+            failsCode = topCode;
+        }
+    }
+
+    std::vector<Grade> grades(plannedCredits.size());
+    int sum = best;
+    for (std::size_t course = plannedCredits.size(); course > 0; --course) {
+        const std::uint8_t code = table[course * width + sum];
+        grades[course - 1] = static_cast<Grade>(code);
+        sum -= plannedCredits[course - 1] * scale.tenths[code];
+    }
+    return makePlan(current, plannedCredits, std::move(grades), scheme);
+}
@@ -0,0 +1,34 @@
+#ifndef GPA_CALC_PLANNER_H
+#define GPA_CALC_PLANNER_H
+
+#include <optional>
+#include <vector>
+
+#include "course.h"
+
+// Grades for a student's planned courses, in the order their credits were given, and the
+// totals (completed plus planned) they lead to.
+struct GradePlan {
+    std::vector<Grade> grades;
+    GpaTotals totals;
+};
+
+// Lowest grade that reaches `target` when earned in every planned course, or nothing if even
+// straight top grades fall short or no course carries credits. `current` holds the completed
+// courses, e.g. a CourseBook's cumulative(), and only grades on the scheme's scale are planned.
+std::optional<Grade> lowestUniformGrade(const GpaTotals& current, const std::vector<int>& plannedCredits,
+                                        double target, GradingScheme scheme = GradingScheme::Fcai);
+
+// The least demanding grades for the planned courses that still reach `target`: fewest weighted
+// grade points in total and, among plans with that total, the lowest top grade. Nothing if
+// the target is out of reach, which includes any target above 0 when neither the completed nor the
+// planned courses carry credits.
+//
+// Every grade point value is a multiple of 0.1, so a plan's points are a whole number of tenths
+// no larger than the top grade's tenths times the planned credits. Instead of trying all 13^n
+// grade combinations, the planner tracks which totals are reachable after each course, which
+// costs O(n * planned credits * 13) however many courses are open.
+std::optional<GradePlan> planGrades(const GpaTotals& current, const std::vector<int>& plannedCredits,
+                                    double target, GradingScheme scheme = GradingScheme::Fcai);
+
+#endif //GPA_CALC_PLANNER_H
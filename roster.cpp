@@ -0,0 +1,210 @@
+#include "roster.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include "stats.h"
+#include "text_reader.h"
+#include "thread_pool.h"
+#include "validation.h"
+
+namespace {
+
+// Chunks have a fixed target size rather than one per thread, so the per-student summation
+// order, and with it every output bit, is the same whatever --threads is set to.
+constexpr std::size_t CHUNK_SIZE = 16 << 20;
+
+// Totals of one chunk, in the order students and courses first appear in it. Ids and names
+// point into the mapped roster, so nothing is copied.
+struct ChunkResult {
+    std::unordered_map<std::string_view, std::size_t> studentIndex;
+    std::vector<StudentTotals> students;
+    std::unordered_map<std::string_view, std::size_t> courseIndex;
+    std::vector<CourseGrades> courses;
+    // Line numbers relative to the chunk.
+    InputReport report;
+    std::size_t lines = 0;
+    std::size_t rows = 0;
+};
+
+// Splits "student,course name,credits,grade". The course name may itself contain commas,
+// so the student is taken from the front and credits and grade from the back. Returns the
+// problem and its column (the line number is left to the caller).
+template <GradingScheme Scheme>
+InputIssue parseRosterLine(std::string_view line, std::string_view& student, std::string_view& course,
+                           int& credits, Grade& grade) {
+    const auto firstComma = line.find(',');
+    const auto lastComma = line.rfind(',');
+    if (firstComma == std::string_view::npos || lastComma == firstComma) {
+        return {InputError::MissingField, 0, 0};
+    }
+    const auto creditsComma = line.rfind(',', lastComma - 1);
+    if (creditsComma == firstComma) {
+        return {InputError::MissingField, 0, 0};
+    }
+
+    student = trim(line.substr(0, firstComma));
+    course = trim(line.substr(firstComma + 1, creditsComma - firstComma - 1));
+    const auto creditsField = trim(line.substr(creditsComma + 1, lastComma - creditsComma - 1));
+    const auto gradeField = trim(line.substr(lastComma + 1));
+    if (student.empty()) {
+        return {InputError::EmptyField, 0, 1};
+    }
+    if (const InputError error = checkCredits(creditsField, credits); error != InputError::None) {
+        return {error, 0, 3};
+    }
+    if (const InputError error = checkGrade<Scheme>(gradeField, grade); error != InputError::None) {
+        return {error, 0, 4};
+    }
+    return {};
+}
+
+// True for a column header such as "student,course,credits,grade": the field where records keep
+// their credits is named "credits", in any case.
+bool isHeaderLine(const std::string_view line) {
+    const auto lastComma = line.rfind(',');
+    if (lastComma == std::string_view::npos || lastComma == 0) return false;
+    const auto creditsComma = line.rfind(',', lastComma - 1);
+    if (creditsComma == std::string_view::npos) return false;
+    const auto field = trim(line.substr(creditsComma + 1, lastComma - creditsComma - 1));
+    constexpr std::string_view CREDITS = "credits";
+    return field.size() == CREDITS.size()
+           && std::equal(field.begin(), field.end(), CREDITS.begin(), [](const char a, const char b) {
+                  return std::tolower(static_cast<unsigned char>(a)) == b;
+              });
+}
+
+// Adds `value` to the entry for `key`, appending a new entry the first time `key` is seen.
+template <typename Entry, typename Add>
+void addTo(std::unordered_map<std::string_view, std::size_t>& index, std::vector<Entry>& entries,
+           const std::string_view key, Add add) {
+    auto [it, inserted] = index.try_emplace(key, entries.size());
+    if (inserted) {
+        entries.push_back({key, {}});
+    }
+    add(entries[it->second]);
+}
+
+// Parses and aggregates the lines in [begin, end), which starts at the start of a line and
+// ends just after a newline (or at the end of the file).
+template <GradingScheme Scheme>
+void aggregateChunk(const char* begin, const char* end, const bool firstChunk, const bool countGrades,
+                    ChunkResult& result) {
+    while (begin < end) {
+        const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        const char* lineEnd = newline ? newline : end;
+        std::string_view line(begin, lineEnd - begin);
+        begin = newline ? newline + 1 : end;
+        ++result.lines;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (trim(line).empty()) continue;
+
+        std::string_view student;
+        std::string_view course;
+        int credits = 0;
+        Grade grade = Grade::F;
+        InputIssue issue = parseRosterLine<Scheme>(line, student, course, credits, grade);
+        if (issue.error != InputError::None) {
+            if (firstChunk && result.lines == 1 && isHeaderLine(line)) continue;
+            issue.line = result.lines;
+            result.report.add(issue);
+            continue;
+        }
+
+        addTo(result.studentIndex, result.students, student, [&](StudentTotals& entry) {
+            entry.totals.add<Scheme>(credits, grade);
+        });
+        if (countGrades) {
+            addTo(result.courseIndex, result.courses, course, [&](CourseGrades& entry) {
+                ++entry.counts[static_cast<std::size_t>(grade)];
+            });
+        }
+        ++result.rows;
+    }
+}
+
+// Splits the roster into chunks of roughly CHUNK_SIZE bytes, each ending at a line boundary.
+std::vector<std::pair<const char*, const char*>> splitChunks(const char* data, const std::size_t size) {
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const char* end = data + size;
+    const char* begin = data;
+    while (begin < end) {
+        const char* split = begin + std::min<std::size_t>(CHUNK_SIZE, end - begin);
+        if (split < end) {
+            const auto* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+            split = newline ? newline + 1 : end;
+        }
+        chunks.emplace_back(begin, split);
+        begin = split;
+    }
+    return chunks;
+}
+
+} // namespace
+
+bool RosterTotals::load(const std::string& filename, const unsigned threads, const bool countGrades,
+                        const GradingScheme scheme) {
+    students_.clear();
+    courses_.clear();
+    rows_ = 0;
+    report_ = {};
+    scheme_ = scheme;
+    if (!roster_.open(filename)) {
+        std::cerr << "Error: Could not open roster file: " << filename << std::endl;
+        return false;
+    }
+    Stats::add(StatCounter::BytesRead, roster_.size());
+
+    const auto chunks = splitChunks(roster_.data(), roster_.size());
+    std::vector<ChunkResult> chunkResults(chunks.size());
+    {
+        ThreadPool pool(threads);
+        withScheme(scheme, [&](auto fixed) {
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                pool.submit([&, i] {
+                    aggregateChunk<decltype(fixed)::value>(chunks[i].first, chunks[i].second, i == 0, countGrades,
+                                                           chunkResults[i]);
+                });
+            }
+            pool.wait();
+        });
+    }
+
+    // Merging chunks in file order keeps students in first-seen order and makes the sums
+    // independent of which thread finished first.
+    std::unordered_map<std::string_view, std::size_t> studentIndex;
+    std::unordered_map<std::string_view, std::size_t> courseIndex;
+    std::size_t linesBefore = 0;
+    for (auto& chunk : chunkResults) {
+        for (const auto& partial : chunk.students) {
+            addTo(studentIndex, students_, partial.id, [&](StudentTotals& entry) {
+                entry.totals.add(partial.totals);
+            });
+        }
+        for (const auto& partial : chunk.courses) {
+            addTo(courseIndex, courses_, partial.name, [&](CourseGrades& entry) {
+                for (int code = 0; code < GRADE_COUNT; ++code) {
+                    entry.counts[code] += partial.counts[code];
+                }
+            });
+        }
+        report_.merge(chunk.report, linesBefore);
+        linesBefore += chunk.lines;
+        rows_ += chunk.rows;
+        chunk = {};
+    }
+    report_.print(std::cerr, filename);
+    Stats::add(StatCounter::RowsParsed, rows_);
+    Stats::add(StatCounter::RowsRejected, report_.rejected());
+    return true;
+}
+
+void writeGpa(std::ostream& out, const std::int64_t thousandths) {
+    const std::int64_t fraction = thousandths % 1000;
+    out << thousandths / 1000 << '.' << (fraction < 100 ? fraction < 10 ? "00" : "0" : "") << fraction;
+}
@@ -0,0 +1,66 @@
+#ifndef GPA_CALC_ROSTER_H
+#define GPA_CALC_ROSTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+#include "mapped_file.h"
+#include "validation.h"
+
+// Number of courses with each letter grade, indexed by grade code.
+using GradeCounts = std::array<std::uint64_t, GRADE_COUNT>;
+
+struct StudentTotals {
+    std::string_view id;
+    GpaTotals totals;
+};
+
+struct CourseGrades {
+    std::string_view name;
+    GradeCounts counts {};
+};
+
+// A roster file with one "student,course name,credits,grade" row per line, graded on one scheme
+// and aggregated per student and, if asked, per course. Grades off the scheme's scale make a line
+// malformed. The file is memory-mapped and split into chunks at line
+// boundaries that are parsed on a work-stealing pool of `threads` workers (zero means one per
+// hardware thread). Partial results are merged in file order, so nothing depends on the thread
+// count. Memory is one entry per distinct student and course, whatever the number of rows; ids
+// and names point into the mapped file and live as long as the RosterTotals.
+class RosterTotals {
+public:
+    // Prints an error and returns false if the file can't be opened. Malformed lines are skipped
+    // and reported on standard error through an InputReport: each chunk collects its own, and they
+    // are merged in file order.
+    bool load(const std::string& filename, unsigned threads = 0, bool countGrades = false,
+              GradingScheme scheme = GradingScheme::Fcai);
+
+    // Students in the order they first appear.
+    const std::vector<StudentTotals>& students() const { return students_; }
+    // Courses in the order they first appear; empty unless grades were counted.
+    const std::vector<CourseGrades>& courses() const { return courses_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t rejected() const { return report_.rejected(); }
+    // The malformed lines, with line numbers in the whole file.
+    const InputReport& report() const { return report_; }
+    GradingScheme scheme() const { return scheme_; }
+
+private:
+    MappedFile roster_;
+    std::vector<StudentTotals> students_;
+    std::vector<CourseGrades> courses_;
+    std::size_t rows_ = 0;
+    InputReport report_;
+    GradingScheme scheme_ = GradingScheme::Fcai;
+};
+
+// Writes a GPA given in thousandths of a point (see GpaTotals::gpaThousandths()) with three decimals.
+void writeGpa(std::ostream& out, std::int64_t thousandths);
+
+#endif //GPA_CALC_ROSTER_H
@@ -0,0 +1,511 @@
+#include "server.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#include "text_reader.h"
+#include "validation.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define GPA_CALC_HAVE_UNIX_SOCKETS 1
+#endif
+
+namespace {
+
+// A client that sends this much without a newline is dropped instead of buffered further.
+constexpr std::size_t MAX_REQUEST_SIZE = 64 << 10;
+constexpr std::size_t READ_CHUNK_SIZE = 16 << 10;
+// FIND falls back to a prefix search, which can match a whole book; cap what it returns.
+constexpr std::size_t MAX_FIND_RESULTS = 100;
+// Books stay resident once opened, so a client naming ever new files can't grow memory without bound.
+constexpr std::size_t MAX_OPEN_BOOKS = 256;
+
+// Book names are plain file names with a data file extension inside the data directory; anything
+// that could reach outside it, or name some other kind of file, is refused.
+bool validBookName(const std::string_view name) {
+    return (name.ends_with(".txt") || name.ends_with(".dat")) && name.size() > 4
+           && name.find('/') == std::string_view::npos && name.find('\\') == std::string_view::npos
+           && name.find('\0') == std::string_view::npos;
+}
+
+// True if the file is missing or empty (a new book), or is a data file: binary, with a text
+// header, or starting with a valid record. Keeps the server from compacting some other file,
+// e.g. a CMakeLists.txt, into a book.
+bool isDataFile(const std::string& filename) {
+    CourseFileHeader header;
+    if (readFileHeader(filename, header) == CourseFileFormat::Binary || header.present) {
+        return true;
+    }
+    std::ifstream inFile(filename, std::ios::binary);
+    std::array<std::string, 3> record;
+    std::size_t lines = 0;
+    while (lines < record.size() && std::getline(inFile, record[lines])) {
+        if (!record[lines].empty() && record[lines].back() == '\r') record[lines].pop_back();
+        ++lines;
+    }
+    CourseView course{};
+    return lines == 0 || (lines == record.size()
+                          && checkTextRecord(record, 3, GradingScheme::Fcai, course).error == InputError::None);
+}
+
+// Parses a 1-based course number into a 0-based position within `courses`.
+bool parsePosition(const std::string_view field, const CourseBook& courses, std::size_t& position) {
+    std::size_t number;
+    if (!parseNumber(field, number) || number == 0 || number > courses.size()) {
+        return false;
+    }
+    position = number - 1;
+    return true;
+}
+
+// Parses "<credits>\t<grade>\t<name>" under the interactive rules, as journal records are parsed;
+// a blank name becomes the next "Unnamed Course N".
+bool parseCourse(const std::string_view fields, const GradingScheme scheme, Course& course, int& unnamedCounter,
+                 std::string& error) {
+    CourseView view{};
+    const InputIssue issue = parseCourseFields(fields, false, scheme, view);
+    if (issue.error == InputError::GradeOffScale) {
+        error = "grade is not on the ";
+        error += schemeName(scheme);
+        error += " scale";
+        return false;
+    }
+    if (issue.error != InputError::None) {
+        error = describe(issue.error);
+        return false;
+    }
+    course.credits = view.credits;
+    course.grade = view.grade;
+    course.name = courseNameOrDefault(std::string(view.name), unnamedCounter);
+    return true;
+}
+
+void appendNumber(std::string& response, const auto number) {
+    char digits[32];
+    response += ' ';
+    response.append(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr);
+}
+
+void appendCourse(std::string& response, const CourseView& course) {
+    appendNumber(response, course.credits);
+    response += ' ';
+    response += gradeLetter(course.grade);
+    response += ' ';
+    response += course.name;
+}
+
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+bool setNonBlocking(const int fd) {
+    const int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 && ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+GpaServer* signalledServer = nullptr;
+
+void stopOnSignal(int) {
+    if (signalledServer) {
+        signalledServer->stop();
+    }
+}
+#endif
+
+} // namespace
+
+GpaServer::GpaServer(std::string dataDirectory) : dataDirectory_(std::move(dataDirectory)) {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    int wake[2];
+    if (::pipe(wake) == 0) {
+        wakeRead_ = wake[0];
+        wakeWrite_ = wake[1];
+        setNonBlocking(wakeRead_);
+        setNonBlocking(wakeWrite_);
+    }
+#endif
+}
+
+GpaServer::~GpaServer() {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    for (const auto& client : clients_) {
+        ::close(client.fd);
+    }
+    if (listener_ >= 0) {
+        ::close(listener_);
+        ::unlink(socketPath_.c_str());
+    }
+    if (wakeRead_ >= 0) {
+        ::close(wakeRead_);
+        ::close(wakeWrite_);
+    }
+#endif
+    commitBooks();
+}
+
+bool GpaServer::listen(const std::string& socketPath) {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path is empty or too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    listener_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ < 0 || !setNonBlocking(listener_)) {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const auto bindSocket = [&] {
+        return ::bind(listener_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    };
+    bool bound = bindSocket();
+    // A socket file nobody answers on was left behind by a server that didn't shut down cleanly.
+    if (!bound && errno == EADDRINUSE) {
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool alive = probe >= 0 &&
+                           ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (alive) {
+            std::cerr << "Error: Another server is already listening on " << socketPath << std::endl;
+            ::close(std::exchange(listener_, -1));
+            return false;
+        }
+        ::unlink(socketPath.c_str());
+        bound = bindSocket();
+    }
+    if (!bound || ::listen(listener_, SOMAXCONN) != 0) {
+        std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        ::close(std::exchange(listener_, -1));
+        return false;
+    }
+    socketPath_ = socketPath;
+    return true;
+#else
+    std::cerr << "Error: Server mode needs Unix domain sockets, which this platform lacks: " << socketPath << std::endl;
+    return false;
+#endif
+}
+
+void GpaServer::stop() {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    // write() is async-signal-safe; a full pipe already holds a pending wakeup.
+    const char byte = 0;
+    [[maybe_unused]] const auto written = ::write(wakeWrite_, &byte, 1);
+#endif
+}
+
+int GpaServer::run() {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    if (listener_ < 0 || wakeRead_ < 0) {
+        return 1;
+    }
+    std::vector<pollfd> polled;
+    while (true) {
+        polled.clear();
+        polled.push_back({wakeRead_, POLLIN, 0});
+        polled.push_back({listener_, POLLIN, 0});
+        for (const auto& client : clients_) {
+            polled.push_back({client.fd, static_cast<short>(client.output.empty() ? POLLIN : POLLOUT), 0});
+        }
+        if (::poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (polled[0].revents != 0) {
+            break;
+        }
+
+        // Run every request that arrived in this wakeup before making any of them durable, so
+        // one fsync per book covers the whole batch.
+        bool answered = false;
+        for (std::size_t i = 0; i < clients_.size(); ++i) {
+            const short events = polled[i + 2].revents;
+            if (events & POLLOUT) {
+                if (!writeClient(clients_[i])) {
+                    clients_[i].closing = true;
+                    clients_[i].output.clear();
+                }
+            } else if (events & (POLLIN | POLLHUP | POLLERR)) {
+                answered |= readClient(clients_[i]);
+            }
+        }
+        if (answered) {
+            commitBooks();
+            sendReplies();
+        }
+
+        const auto finished = std::remove_if(clients_.begin(), clients_.end(), [](const Client& client) {
+            if (client.closing && client.output.empty()) {
+                ::close(client.fd);
+                return true;
+            }
+            return false;
+        });
+        clients_.erase(finished, clients_.end());
+        // Accept after pruning, so the client indices above match the poll set.
+        if (polled[1].revents & POLLIN) {
+            acceptClients();
+        }
+    }
+    commitBooks();
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+void GpaServer::acceptClients() {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    while (true) {
+        const int fd = ::accept(listener_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        clients_.push_back({fd, {}, {}, {}});
+    }
+#endif
+}
+
+// Reads what the client sent and answers each complete line into its held replies. Returns true if
+// anything was answered.
+bool GpaServer::readClient(Client& client) {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    char chunk[READ_CHUNK_SIZE];
+    while (true) {
+        const auto received = ::read(client.fd, chunk, sizeof(chunk));
+        if (received > 0) {
+            client.input.append(chunk, static_cast<std::size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            client.closing = true;
+        }
+        break;
+    }
+
+    std::size_t consumed = 0;
+    std::size_t newline;
+    while ((newline = client.input.find('\n', consumed)) != std::string::npos) {
+        std::string_view line(client.input.data() + consumed, newline - consumed);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        Book* changed = nullptr;
+        std::string text = handle(line, changed);
+        client.replies.push_back({changed, std::move(text)});
+        consumed = newline + 1;
+    }
+    client.input.erase(0, consumed);
+    if (client.input.size() > MAX_REQUEST_SIZE) {
+        client.replies.push_back({nullptr, "ERR request too long"});
+        client.input.clear();
+        client.closing = true;
+    }
+    return !client.replies.empty();
+#else
+    return false;
+#endif
+}
+
+// Sends as much pending output as the socket takes. Returns false if the client is gone.
+bool GpaServer::writeClient(Client& client) {
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    std::size_t sent = 0;
+    while (sent < client.output.size()) {
+        const auto written = ::write(client.fd, client.output.data() + sent, client.output.size() - sent);
+        if (written > 0) {
+            sent += static_cast<std::size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+    client.output.erase(0, sent);
+    return true;
+#else
+    return false;
+#endif
+}
+
+GpaServer::Book* GpaServer::openBook(const std::string_view name, std::string& error) {
+    if (const auto found = books_.find(name); found != books_.end()) {
+        return found->second.get();
+    }
+    if (!validBookName(name)) {
+        error = "invalid book name";
+        return nullptr;
+    }
+    if (books_.size() >= MAX_OPEN_BOOKS) {
+        error = "too many open books";
+        return nullptr;
+    }
+
+    const std::string filename = dataDirectory_ + '/' + std::string(name);
+    if (!isDataFile(filename)) {
+        error = "not a data file";
+        return nullptr;
+    }
+    auto book = std::make_unique<Book>(filename);
+    const auto format = loadCourses(book->courses, book->unnamedCounter, filename);
+    if (!format) {
+        // Compacting a partly read book would overwrite the rest of the file.
+        error = "could not read book";
+        return nullptr;
+    }
+    book->format = *format;
+    // The server answers OK only for durable changes, so changes an interrupted session left
+    // uncommitted are adopted and committed with the next batch rather than left pending.
+    if (const std::size_t recovered = book->journal.replay(book->courses, book->unnamedCounter)) {
+        std::cerr << "Recovered " << recovered << " unsaved change(s) in " << filename << "\n";
+        book->dirty = true;
+    }
+    return books_.emplace(std::string(name), std::move(book)).first->second.get();
+}
+
+std::string GpaServer::handle(const std::string_view request) {
+    Book* changed = nullptr;
+    return handle(request, changed);
+}
+
+std::string GpaServer::handle(std::string_view request, Book*& changed) {
+    const std::string_view command = nextField(request);
+    std::string error;
+    Book* book = nullptr;
+    if (command == "GPA" || command == "GET" || command == "FIND" || command == "ADD" || command == "EDIT" ||
+        command == "DELETE") {
+        book = openBook(nextField(request), error);
+        if (!book) {
+            return "ERR " + error;
+        }
+    } else {
+        return "ERR unknown command";
+    }
+
+    CourseBook& courses = book->courses;
+    std::string response = "OK";
+    std::size_t position = 0;
+    if (command == "GPA") {
+        appendNumber(response, calculateGPA(courses));
+        appendNumber(response, totalHours(courses));
+        appendNumber(response, courses.size());
+        return response;
+    }
+    if (command == "FIND") {
+        const std::string_view name = trim(request);
+        std::vector<std::size_t> matches = courses.findByName(name);
+        if (matches.empty()) {
+            matches = courses.findByPrefix(name, MAX_FIND_RESULTS);
+        }
+        for (const std::size_t match : matches) {
+            appendNumber(response, match + 1);
+        }
+        return response;
+    }
+    if (command == "ADD") {
+        Course course;
+        if (!parseCourse(request, courses.scheme(), course, book->unnamedCounter, error)) {
+            return "ERR " + error;
+        }
+        // Like the menu, new courses go into the latest term.
+        course.term = std::max(1, courses.terms().lastTerm());
+        courses.add(course);
+        book->journal.recordAdd(courses[courses.size() - 1]);
+        book->dirty = true;
+        changed = book;
+        appendNumber(response, courses.size());
+        return response;
+    }
+
+    if (!parsePosition(nextField(request), courses, position)) {
+        return "ERR no such course";
+    }
+    if (command == "GET") {
+        appendCourse(response, courses[position]);
+    } else if (command == "EDIT") {
+        Course course;
+        if (!parseCourse(request, courses.scheme(), course, book->unnamedCounter, error)) {
+            return "ERR " + error;
+        }
+        course.term = courses[position].term;
+        courses.replace(position, course);
+        book->journal.recordReplace(position, courses[position]);
+        book->dirty = true;
+        changed = book;
+    } else {
+        courses.remove(position);
+        book->journal.recordRemove(position);
+        book->dirty = true;
+        changed = book;
+    }
+    return response;
+}
+
+// Makes every change handled so far durable, compacting journals the way saving on exit does.
+void GpaServer::commitBooks() {
+    for (auto& [name, book] : books_) {
+        if (!book->dirty) {
+            continue;
+        }
+        book->unsaved = !saveWithJournal(book->journal, book->courses, book->filename, book->format,
+                                         book->unnamedCounter);
+        book->dirty = book->unsaved;
+    }
+}
+
+// Queues the held responses for sending, now that the batch is committed, and sends what the
+// sockets take.
+void GpaServer::sendReplies() {
+    for (auto& client : clients_) {
+        for (const Reply& reply : client.replies) {
+            client.output += reply.changed && reply.changed->unsaved ? "ERR could not save changes" : reply.text;
+            client.output += '\n';
+        }
+        client.replies.clear();
+        if (!client.output.empty() && !writeClient(client)) {
+            client.closing = true;
+            client.output.clear();
+        }
+    }
+}
+
+int runServer(const std::string& socketPath) {
+    GpaServer server;
+    if (!server.listen(socketPath)) {
+        return 1;
+    }
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    signalledServer = &server;
+    struct sigaction action {};
+    action.sa_handler = stopOnSignal;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+    // A client hanging up mid-response must not kill the server.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    std::cerr << "Serving GPA requests on " << socketPath << "\n";
+    const int status = server.run();
+#ifdef GPA_CALC_HAVE_UNIX_SOCKETS
+    signalledServer = nullptr;
+#endif
+    return status;
+}
@@ -0,0 +1,100 @@
+#ifndef GPA_CALC_SERVER_H
+#define GPA_CALC_SERVER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "course_book.h"
+#include "journal.h"
+#include "storage.h"
+
+// Keeps course books resident and serves them over a Unix domain socket, so a query costs a
+// round trip instead of a process start and a full load of the data file. Requests and responses
+// are single tab-separated lines:
+//
+//   GPA    <book>                                    OK <gpa> <hours> <courses>
+//   GET    <book> <number>                           OK <credits> <grade> <name>
+//   FIND   <book> <name>                             OK <number>...
+//   ADD    <book> <credits> <grade> <name>           OK <number>
+//   EDIT   <book> <number> <credits> <grade> <name>  OK
+//   DELETE <book> <number>                           OK
+//
+// A book is a data file in the server's data directory (e.g. "gpa_data.txt"), loaded with its
+// journal on first use. Only names ending in ".txt" or ".dat" are accepted, for files that are data
+// files or don't exist yet, and at most 256 stay open. Numbers are 1-based positions as in the
+// menu, and names follow the interactive rules: a blank name becomes the next "Unnamed Course N".
+// Failures answer "ERR <message>".
+//
+// The server is a single-threaded poll loop. Everything that arrives from all ready clients in
+// one wakeup is handled as a batch: changes are journaled, each touched book is committed with
+// one fsync, and only then are the responses sent, so an OK means the change is durable. If a
+// book can't be committed, its changes in the batch are answered "ERR could not save changes";
+// they stay in memory and are committed with the next batch that succeeds. Batches that only read
+// never touch the disk.
+class GpaServer {
+public:
+    explicit GpaServer(std::string dataDirectory = ".");
+    ~GpaServer();
+    GpaServer(const GpaServer&) = delete;
+    GpaServer& operator=(const GpaServer&) = delete;
+
+    // Binds and listens on `socketPath`, replacing a stale socket left by a previous run.
+    bool listen(const std::string& socketPath);
+    // Serves until stop() is called, then commits every book. Returns a process exit code.
+    int run();
+    // Makes run() return; safe to call from another thread or a signal handler.
+    void stop();
+
+    // Executes one request line and returns its response line (without the newline).
+    std::string handle(std::string_view request);
+
+private:
+    struct Book {
+        explicit Book(const std::string& filename) : filename(filename), journal(filename + ".journal") {}
+
+        std::string filename;
+        CourseBook courses;
+        int unnamedCounter = 0;
+        CourseFileFormat format = CourseFileFormat::Text;
+        Journal journal;
+        bool dirty = false;
+        // Set when the last commit failed, so this batch's changes to the book are answered ERR.
+        bool unsaved = false;
+    };
+    // A response held until the batch is committed, with the book it changed, if any.
+    struct Reply {
+        Book* changed;
+        std::string text;
+    };
+    struct Client {
+        int fd;
+        std::string input;
+        std::string output;
+        std::vector<Reply> replies;
+        bool closing = false;
+    };
+
+    Book* openBook(std::string_view name, std::string& error);
+    std::string handle(std::string_view request, Book*& changed);
+    void acceptClients();
+    bool readClient(Client& client);
+    bool writeClient(Client& client);
+    void commitBooks();
+    void sendReplies();
+
+    std::string dataDirectory_;
+    std::string socketPath_;
+    int listener_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+    std::vector<Client> clients_;
+    std::map<std::string, std::unique_ptr<Book>, std::less<>> books_;
+};
+
+// Runs a GpaServer on `socketPath` until SIGINT or SIGTERM. Returns a process exit code.
+int runServer(const std::string& socketPath);
+
+#endif //GPA_CALC_SERVER_H
@@ -0,0 +1,68 @@
+#include "shared_course_book.h"
+
+#include <thread>
+
+namespace {
+
+// Spreads reader threads over the counter shards, one fixed shard per thread.
+std::size_t readShard() {
+    static std::atomic<std::size_t> nextShard{0};
+    thread_local const std::size_t shard = nextShard.fetch_add(1) % SharedCourseBook::READ_SHARDS;
+    return shard;
+}
+
+} // namespace
+
+SharedCourseBook::SharedCourseBook(const CourseBook& courses) {
+    for (auto& book : books_) {
+        book.reserve(courses.size());
+        for (const auto& course : courses) {
+            book.add(course);
+        }
+    }
+}
+
+SharedCourseBook::Snapshot SharedCourseBook::read() const {
+    // All atomics are sequentially consistent: the writer must see this arrival before it
+    // checks the indicator, or it could overwrite the copy being read.
+    std::atomic<std::size_t>& readers = indicators_[version_.load()][readShard()].readers;
+    readers.fetch_add(1);
+    return {&books_[reading_.load()], &readers};
+}
+
+void SharedCourseBook::add(const CourseView& course) {
+    write([&](CourseBook& book) { book.add(course); });
+}
+
+void SharedCourseBook::replace(const std::size_t position, const CourseView& course) {
+    write([&](CourseBook& book) { book.replace(position, course); });
+}
+
+void SharedCourseBook::remove(const std::size_t position) {
+    write([&](CourseBook& book) { book.remove(position); });
+}
+
+template <typename Edit>
+void SharedCourseBook::write(const Edit& edit) {
+    const std::lock_guard lock(writeMutex_);
+    const unsigned reading = reading_.load();
+    edit(books_[1 - reading]);
+    reading_.store(1 - reading);
+
+    // Readers that registered before the switch may still be on the old copy. Flip new arrivals
+    // to the other indicator and wait out both, so no reader can be left on books_[reading].
+    const unsigned version = version_.load();
+    waitForReaders(indicators_[1 - version]);
+    version_.store(1 - version);
+    waitForReaders(indicators_[version]);
+
+    edit(books_[reading]);
+}
+
+void SharedCourseBook::waitForReaders(const ReadIndicator& indicator) const {
+    for (const auto& counter : indicator) {
+        while (counter.readers.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
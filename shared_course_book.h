@@ -0,0 +1,102 @@
+#ifndef GPA_CALC_SHARED_COURSE_BOOK_H
+#define GPA_CALC_SHARED_COURSE_BOOK_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+#include "course_book.h"
+
+// A CourseBook that any number of threads can read while one thread at a time edits it. Readers
+// never wait and never take a lock: read() hands out a Snapshot, a consistent view of the book as
+// of one completed edit, that stays unchanged for as long as it is held.
+//
+// This is the left-right technique: the book is kept twice. An edit is applied to the copy no
+// reader is directed to, readers are switched over to it, and once the last reader of the old
+// copy has left, the edit is replayed there. Readers announce themselves on sharded, cache-line
+// padded counters, so concurrent readers don't contend on one cache line. The cost is twice the
+// memory and every edit done twice, and an edit waits for snapshots of the copy it is about to
+// overwrite; keep snapshots short-lived, and never edit while holding one on the same thread.
+class SharedCourseBook {
+public:
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept : courses_(other.courses_), readers_(other.readers_) {
+            other.readers_ = nullptr;
+        }
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot() {
+            if (readers_) {
+                readers_->fetch_sub(1);
+            }
+        }
+
+        std::size_t size() const { return courses_->size(); }
+        bool empty() const { return courses_->empty(); }
+        CourseView operator[](const std::size_t position) const { return (*courses_)[position]; }
+        std::vector<std::size_t> findByName(const std::string_view name) const { return courses_->findByName(name); }
+        const GpaTotals& totals() const { return courses_->totals(); }
+        GpaTotals cumulative() const { return courses_->cumulative(); }
+        const TermTotals& terms() const { return courses_->terms(); }
+
+    private:
+        friend class SharedCourseBook;
+        Snapshot(const CourseBook* courses, std::atomic<std::size_t>* readers)
+            : courses_(courses), readers_(readers) {}
+
+        // Only the CourseBook accessors that don't write the book may be used here: findByPrefix()
+        // indexes names lazily and would race with other readers.
+        const CourseBook* courses_;
+        std::atomic<std::size_t>* readers_;
+    };
+
+    SharedCourseBook() = default;
+    explicit SharedCourseBook(const CourseBook& courses);
+    SharedCourseBook(const SharedCourseBook&) = delete;
+    SharedCourseBook& operator=(const SharedCourseBook&) = delete;
+
+    Snapshot read() const;
+
+    void add(const CourseView& course);
+    void add(const Course& course) { add(CourseView{course.name, course.credits, course.grade, course.term}); }
+    void replace(std::size_t position, const CourseView& course);
+    void replace(std::size_t position, const Course& course) {
+        replace(position, CourseView{course.name, course.credits, course.grade, course.term});
+    }
+    void remove(std::size_t position);
+
+    static constexpr std::size_t READ_SHARDS = 32;
+
+private:
+    struct alignas(64) ReadCounter {
+        std::atomic<std::size_t> readers{0};
+    };
+    using ReadIndicator = std::array<ReadCounter, READ_SHARDS>;
+
+    // Applies `edit` to both copies, switching readers between them. `edit` must behave the same
+    // on both, so it must not depend on anything it changes.
+    template <typename Edit>
+    void write(const Edit& edit);
+    void waitForReaders(const ReadIndicator& indicator) const;
+
+    std::array<CourseBook, 2> books_;
+    // Readers register on the indicator selected by version_ and then read books_[reading_].
+    mutable std::array<ReadIndicator, 2> indicators_;
+    std::atomic<unsigned> reading_{0};
+    std::atomic<unsigned> version_{0};
+    std::mutex writeMutex_;
+};
+
+inline double calculateGPA(const SharedCourseBook::Snapshot& courses) {
+    return courses.cumulative().gpa();
+}
+
+inline int totalHours(const SharedCourseBook::Snapshot& courses) {
+    return courses.cumulative().credits;
+}
+
+#endif //GPA_CALC_SHARED_COURSE_BOOK_H
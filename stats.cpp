@@ -0,0 +1,182 @@
+#include "stats.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+namespace {
+
+constexpr const char* COUNTER_NAMES[] = {
+    "bytes_read", "bytes_written", "rows_parsed", "rows_rejected", "allocations", "allocated_bytes", "menu_actions"
+};
+constexpr const char* TIMER_NAMES[] = {
+    "load_courses", "save_courses", "calculate_gpa", "journal_replay", "menu_render", "batch",
+    "analytics"
+};
+
+static_assert(std::size(COUNTER_NAMES) == static_cast<std::size_t>(StatCounter::Count));
+static_assert(std::size(TIMER_NAMES) == static_cast<std::size_t>(StatTimer::Count));
+
+struct TimerTotals {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> totalNanoseconds{0};
+    std::atomic<std::uint64_t> maxNanoseconds{0};
+};
+
+std::array<TimerTotals, static_cast<std::size_t>(StatTimer::Count)> timers;
+StatsFormat reportFormat = StatsFormat::Text;
+
+double milliseconds(const std::uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e6;
+}
+
+} // namespace
+
+#ifndef GPA_CALC_NO_STATS
+
+namespace {
+
+void* countedMalloc(const std::size_t size) noexcept {
+    if (Stats::enabled()) {
+        Stats::add(StatCounter::Allocations);
+        Stats::add(StatCounter::AllocatedBytes, size);
+    }
+    // malloc(0) may return null, which new must not.
+    return std::malloc(size ? size : 1);
+}
+
+void* countedNew(const std::size_t size) {
+    if (void* memory = countedMalloc(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+// Counting replacements for the global allocation functions. Every unaligned form is replaced, so
+// whatever new allocated is freed by the matching delete here (sanitizers check that pairing);
+// the aligned forms are left alone and stay paired with each other. Together these catch every
+// allocation the program makes through new, including the standard containers'.
+void* operator new(const std::size_t size) {
+    return countedNew(size);
+}
+
+void* operator new[](const std::size_t size) {
+    return countedNew(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+    return countedMalloc(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+    return countedMalloc(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+#endif
+
+void Stats::enable(const StatsFormat format) {
+    reportFormat = format;
+#ifdef GPA_CALC_NO_STATS
+    std::cerr << "Warning: This build has no stats support; --stats is ignored." << std::endl;
+#else
+    if (!enabled_.exchange(true)) {
+        std::atexit([] { report(std::cerr, reportFormat); });
+    }
+#endif
+}
+
+void Stats::enableFromEnvironment() {
+    const char* value = std::getenv("GPA_CALC_STATS");
+    if (value && *value && std::string_view(value) != "0") {
+        enable(std::string_view(value) == "json" ? StatsFormat::Json : StatsFormat::Text);
+    }
+}
+
+bool Stats::parseFormat(const std::string_view value, StatsFormat& format) {
+    if (value.empty() || value == "text") {
+        format = StatsFormat::Text;
+    } else if (value == "json") {
+        format = StatsFormat::Json;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Stats::record(const StatTimer timer, const std::uint64_t nanoseconds) {
+    TimerTotals& totals = timers[static_cast<std::size_t>(timer)];
+    totals.calls.fetch_add(1, std::memory_order_relaxed);
+    totals.totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    std::uint64_t max = totals.maxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !totals.maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void Stats::report(std::ostream& out, const StatsFormat format) {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    if (format == StatsFormat::Json) {
+        out << "{\"counters\":{";
+        for (std::size_t i = 0; i < counters_.size(); ++i) {
+            out << (i ? "," : "") << '"' << COUNTER_NAMES[i] << "\":" << counters_[i].load(std::memory_order_relaxed);
+        }
+        out << "},\"timers\":{";
+        bool first = true;
+        for (std::size_t i = 0; i < timers.size(); ++i) {
+            const std::uint64_t calls = timers[i].calls.load(std::memory_order_relaxed);
+            if (calls == 0) continue;
+            out << (first ? "" : ",") << '"' << TIMER_NAMES[i] << "\":{\"calls\":" << calls
+                << ",\"total_ms\":" << milliseconds(timers[i].totalNanoseconds.load(std::memory_order_relaxed))
+                << ",\"max_ms\":" << milliseconds(timers[i].maxNanoseconds.load(std::memory_order_relaxed)) << '}';
+            first = false;
+        }
+        out << "}}\n";
+    } else {
+        out << "\n--- Stats ---\n";
+        for (std::size_t i = 0; i < counters_.size(); ++i) {
+            out << std::left << std::setw(18) << COUNTER_NAMES[i] << std::right << std::setw(14)
+                << counters_[i].load(std::memory_order_relaxed) << '\n';
+        }
+        for (std::size_t i = 0; i < timers.size(); ++i) {
+            const std::uint64_t calls = timers[i].calls.load(std::memory_order_relaxed);
+            if (calls == 0) continue;
+            const std::uint64_t total = timers[i].totalNanoseconds.load(std::memory_order_relaxed);
+            out << std::left << std::setw(18) << TIMER_NAMES[i] << std::right << std::setw(8) << calls << " calls"
+                << std::setw(12) << milliseconds(total) << " ms total" << std::setw(12) << milliseconds(total / calls)
+                << " ms avg" << std::setw(12)
+                << milliseconds(timers[i].maxNanoseconds.load(std::memory_order_relaxed)) << " ms max\n";
+        }
+    }
+    out.flush();
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,102 @@
+#ifndef GPA_CALC_STATS_H
+#define GPA_CALC_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Opt-in instrumentation of the hot paths: scoped timers and event counters, reported when the
+// process exits. It is off unless `--stats` is passed or GPA_CALC_STATS is set in the environment;
+// while off, every probe is one relaxed load of a flag. Building with GPA_CALC_NO_STATS (the CMake
+// option GPA_CALC_STATS=OFF) compiles the probes out entirely.
+//
+// Probes may fire from any thread. Allocations are counted by a replacement of the global
+// operator new, which only touches the counters while stats are enabled.
+
+enum class StatCounter {
+    BytesRead,
+    BytesWritten,
+    RowsParsed,
+    RowsRejected,
+    Allocations,
+    AllocatedBytes,
+    MenuActions,
+    Count
+};
+
+enum class StatTimer {
+    LoadCourses,
+    SaveCourses,
+    CalculateGPA,
+    JournalReplay,
+    MenuRender,
+    Batch,
+    Analytics,
+    Count
+};
+
+enum class StatsFormat {
+    Text,
+    Json
+};
+
+class Stats {
+public:
+    static bool enabled() {
+#ifdef GPA_CALC_NO_STATS
+        return false;
+#else
+        return enabled_.load(std::memory_order_relaxed);
+#endif
+    }
+
+    // Turns collection on and prints a report to standard error when the process exits.
+    static void enable(StatsFormat format);
+    // Enables stats if GPA_CALC_STATS is set: "json" selects JSON, any other value the text report.
+    static void enableFromEnvironment();
+    // Parses a --stats option value ("", "text" or "json").
+    static bool parseFormat(std::string_view value, StatsFormat& format);
+
+    static void add(const StatCounter counter, const std::uint64_t amount = 1) {
+        if (enabled()) {
+            counters_[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+    static void record(StatTimer timer, std::uint64_t nanoseconds);
+
+    static void report(std::ostream& out, StatsFormat format);
+
+private:
+    // Inline so the probes compile to a load and an add; the timers live in stats.cpp.
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(StatCounter::Count)> counters_{};
+};
+
+// Times its scope into a StatTimer. The clock is only read while stats are enabled.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const StatTimer timer) : timer_(timer) {
+        if (Stats::enabled()) {
+            running_ = true;
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedTimer() {
+        if (running_) {
+            const auto elapsed = std::chrono::steady_clock::now() - start_;
+            Stats::record(timer_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    StatTimer timer_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif //GPA_CALC_STATS_H
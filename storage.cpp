@@ -0,0 +1,539 @@
+#include "storage.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "atomic_file.h"
+#include "mapped_courses.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+static_assert(std::endian::native == std::endian::little, "the binary data format is little-endian");
+static_assert(sizeof(BinaryHeader) == 40, "BinaryHeader must stay packed");
+static_assert(offsetof(BinaryHeader, unnamedCounter) == BINARY_V1_HEADER_SIZE, "version 2 fields follow the version 1 header");
+
+namespace {
+
+// Courses per formatting task, and formatting tasks per batch. A text save holds at most two
+// batches of formatted text, the one being written and the one being formatted, however large
+// the book is.
+constexpr std::size_t SAVE_CHUNK = 1 << 15;
+constexpr std::size_t SAVE_BATCH = 64;
+
+// Iterators to the first course of every SAVE_CHUNK courses. Stepping a CourseBook iterator
+// only bumps a slot number, so this is cheap for both course lists.
+template <typename CourseList>
+auto chunkStarts(const CourseList& courses) {
+    std::vector<decltype(courses.begin())> starts;
+    auto course = courses.begin();
+    const std::size_t count = courses.size();
+    for (std::size_t first = 0; first < count; first += SAVE_CHUNK) {
+        starts.push_back(course);
+        for (std::size_t i = first; i < count && i < first + SAVE_CHUNK; ++i) {
+            ++course;
+        }
+    }
+    return starts;
+}
+
+std::size_t chunkSize(const std::size_t chunk, const std::size_t count) {
+    return std::min(SAVE_CHUNK, count - chunk * SAVE_CHUNK);
+}
+
+// A pool for formatting `chunks` chunks, or none when there is only one and threads wouldn't pay.
+std::unique_ptr<ThreadPool> savePool(const std::size_t chunks) {
+    if (chunks <= 1) {
+        return nullptr;
+    }
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::make_unique<ThreadPool>(static_cast<unsigned>(std::min(cores, chunks)));
+}
+
+template <typename Task>
+void runOn(const std::unique_ptr<ThreadPool>& pool, Task&& task) {
+    if (pool) {
+        pool->submit(std::forward<Task>(task));
+    } else {
+        task();
+    }
+}
+
+template <typename Iterator>
+void formatText(Iterator course, std::size_t count, const GradingScheme scheme, std::string& buffer) {
+    char number[32];
+    buffer.clear();
+    buffer.reserve(count * 32);
+    for (; count > 0; --count, ++course) {
+        const auto& view = *course;
+        buffer += view.name;
+        buffer += '\n';
+        buffer.append(number, std::to_chars(number, number + sizeof(number), view.credits).ptr);
+        buffer += '\n';
+        // Shortest representation that reads back to the exact same double.
+        buffer.append(number, std::to_chars(number, number + sizeof(number), gradePoints(view.grade, scheme)).ptr);
+        buffer += '\n';
+        buffer.append(number, std::to_chars(number, number + sizeof(number), view.term).ptr);
+        buffer += '\n';
+    }
+}
+
+// Both savers take a std::vector<Course> or a CourseBook. Chunks of courses are formatted in
+// parallel into their own buffers, and the buffers handed to the file in order.
+template <typename CourseList>
+bool saveText(const CourseList& courses, const int unnamedCounter, const GradingScheme scheme, AtomicFile& outFile) {
+    std::string header(TEXT_HEADER_PREFIX);
+    header += " unnamed=";
+    header += std::to_string(unnamedCounter);
+    header += " fields=4";
+    if (scheme != GradingScheme::Fcai) {
+        header += " scheme=";
+        header += schemeName(scheme);
+    }
+    header += '\n';
+    if (!outFile.write(header)) {
+        return false;
+    }
+
+    const auto starts = chunkStarts(courses);
+    const std::size_t count = courses.size();
+    const std::unique_ptr<ThreadPool> pool = savePool(starts.size());
+    std::array<std::vector<std::string>, 2> batches;
+    const auto formatBatch = [&](const std::size_t batch) {
+        std::vector<std::string>& buffers = batches[batch % 2];
+        const std::size_t first = batch * SAVE_BATCH;
+        buffers.resize(std::min(SAVE_BATCH, starts.size() - first));
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            runOn(pool, [&, i, chunk = first + i] { formatText(starts[chunk], chunkSize(chunk, count), scheme, buffers[i]); });
+        }
+    };
+
+    // Format the next batch while the current one is written.
+    const std::size_t batchCount = (starts.size() + SAVE_BATCH - 1) / SAVE_BATCH;
+    if (batchCount > 0) {
+        formatBatch(0);
+    }
+    bool written = true;
+    std::vector<std::string_view> pieces;
+    for (std::size_t batch = 0; batch < batchCount; ++batch) {
+        if (pool) {
+            pool->wait();
+        }
+        if (batch + 1 < batchCount) {
+            formatBatch(batch + 1);
+        }
+        pieces.assign(batches[batch % 2].begin(), batches[batch % 2].end());
+        written = written && outFile.write(pieces);
+    }
+    if (pool) {
+        pool->wait();
+    }
+    return written;
+}
+
+template <typename CourseList>
+bool saveBinary(const CourseList& courses, const int unnamedCounter, const GradingScheme scheme, AtomicFile& outFile) {
+    const auto starts = chunkStarts(courses);
+    const std::size_t count = courses.size();
+    const std::unique_ptr<ThreadPool> pool = savePool(starts.size());
+
+    // First pass: the size of each chunk's names, and the first course binary files can't hold.
+    struct ChunkInfo {
+        std::size_t namesSize = 0;
+        std::string invalidName;
+        bool valid = true;
+    };
+    std::vector<ChunkInfo> chunks(starts.size());
+    for (std::size_t chunk = 0; chunk < starts.size(); ++chunk) {
+        runOn(pool, [&, chunk] {
+            ChunkInfo& info = chunks[chunk];
+            auto course = starts[chunk];
+            for (std::size_t i = chunkSize(chunk, count); i > 0; --i, ++course) {
+                const auto& view = *course;
+                const int credits = view.credits;
+                info.namesSize += view.name.size();
+                if (info.valid && (credits < 0 || credits > UINT8_MAX || !validTerm(view.term))) {
+                    info.valid = false;
+                    info.invalidName = view.name;
+                }
+            }
+        });
+    }
+    if (pool) {
+        pool->wait();
+    }
+
+    std::size_t namesSize = 0;
+    std::vector<std::size_t> nameOffsets(chunks.size());
+    for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+        if (!chunks[chunk].valid) {
+            std::cerr << "Error: Course \"" << chunks[chunk].invalidName << "\" can't be stored in binary format." << std::endl;
+            return false;
+        }
+        nameOffsets[chunk] = namesSize;
+        namesSize += chunks[chunk].namesSize;
+    }
+
+    const std::size_t offsetsStart = sizeof(BinaryHeader);
+    const std::size_t namesStart = offsetsStart + (count + 1) * sizeof(std::uint64_t);
+    const std::size_t creditsStart = namesStart + namesSize;
+    const std::size_t gradesStart = creditsStart + count;
+    const std::size_t termsStart = gradesStart + count;
+    const std::size_t fileSize = termsStart + count;
+    // Every byte is written below, so skip zeroing the buffer.
+    const auto buffer = std::make_unique_for_overwrite<char[]>(fileSize);
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.courseCount = count;
+    header.namesSize = namesSize;
+    header.unnamedCounter = static_cast<std::uint32_t>(std::max(unnamedCounter, 0));
+    header.scheme = static_cast<std::uint32_t>(scheme);
+    std::memcpy(buffer.get(), &header, sizeof(header));
+
+    // Second pass: each chunk fills its own rows of every column.
+    for (std::size_t chunk = 0; chunk < starts.size(); ++chunk) {
+        runOn(pool, [&, chunk] {
+            std::uint64_t offset = nameOffsets[chunk];
+            auto course = starts[chunk];
+            const std::size_t first = chunk * SAVE_CHUNK;
+            for (std::size_t i = first; i < first + chunkSize(chunk, count); ++i, ++course) {
+                const auto& view = *course;
+                std::memcpy(buffer.get() + offsetsStart + i * sizeof(offset), &offset, sizeof(offset));
+                std::memcpy(buffer.get() + namesStart + offset, view.name.data(), view.name.size());
+                buffer[creditsStart + i] = static_cast<char>(view.credits);
+                buffer[gradesStart + i] = static_cast<char>(view.grade);
+                buffer[termsStart + i] = static_cast<char>(view.term);
+                offset += view.name.size();
+            }
+        });
+    }
+    if (pool) {
+        pool->wait();
+    }
+    const std::uint64_t end = namesSize;
+    std::memcpy(buffer.get() + offsetsStart + count * sizeof(end), &end, sizeof(end));
+
+    return outFile.write(std::string_view(buffer.get(), fileSize));
+}
+
+// Reads a whole binary file with a single read and hands each course to the handler. Version 2
+// files also report their metadata through `fileHeader` before the first course is handed over.
+template <typename CourseHandler>
+bool readBinary(const std::string& filename, CourseHandler&& handler, CourseFileHeader& fileHeader) {
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+    if (!inFile.is_open()) {
+        std::cerr << "Error: Could not read binary data file: " << filename << std::endl;
+        return false;
+    }
+    const auto fileSize = static_cast<std::size_t>(inFile.tellg());
+    std::vector<char> buffer(fileSize);
+    inFile.seekg(0);
+    if (!inFile.read(buffer.data(), static_cast<std::streamsize>(fileSize))) {
+        std::cerr << "Error: Could not read binary data file: " << filename << std::endl;
+        return false;
+    }
+    Stats::add(StatCounter::BytesRead, fileSize);
+
+    BinaryHeader header;
+    if (!readBinaryHeader(buffer.data(), fileSize, header)) {
+        std::cerr << "Error: Corrupt or unsupported binary data file: " << filename << std::endl;
+        return false;
+    }
+    if (header.version >= 2) {
+        fileHeader.present = true;
+        fileHeader.unnamedCounter = static_cast<int>(std::min<std::uint32_t>(header.unnamedCounter, INT32_MAX));
+    }
+    const auto scheme = static_cast<GradingScheme>(header.scheme);
+    fileHeader.scheme = scheme;
+
+    const std::size_t count = header.courseCount;
+    const char* offsets = buffer.data() + binaryHeaderSize(header.version);
+    const char* names = offsets + (count + 1) * sizeof(std::uint64_t);
+    const auto* credits = reinterpret_cast<const unsigned char*>(names + header.namesSize);
+    const auto* grades = credits + count;
+    const auto* terms = header.version >= 3 ? grades + count : nullptr;
+
+    std::uint64_t begin;
+    std::memcpy(&begin, offsets, sizeof(begin));
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t end;
+        std::memcpy(&end, offsets + (i + 1) * sizeof(end), sizeof(end));
+        const int term = terms ? terms[i] : 1;
+        if (begin > end || end > header.namesSize || grades[i] >= GRADE_COUNT
+            || !onScale(static_cast<Grade>(grades[i]), scheme) || !validTerm(term)) {
+            std::cerr << "Error: Corrupt binary data file: " << filename << std::endl;
+            return false;
+        }
+        handler(CourseView{std::string_view(names + begin, end - begin), credits[i], static_cast<Grade>(grades[i]), term});
+        begin = end;
+    }
+    return true;
+}
+
+template <typename CourseList>
+bool saveAll(const CourseList& courses, const std::string& filename, const CourseFileFormat format,
+             const int unnamedCounter, const GradingScheme scheme) {
+    const ScopedTimer timer(StatTimer::SaveCourses);
+    AtomicFile outFile;
+    if (!outFile.open(filename)) {
+        std::cerr << "Error: Could not open file for saving: " << filename << std::endl;
+        return false;
+    }
+
+    const bool saved = format == CourseFileFormat::Binary ? saveBinary(courses, unnamedCounter, scheme, outFile)
+                                                          : saveText(courses, unnamedCounter, scheme, outFile);
+    if (!saved || !outFile.commit()) {
+        std::cerr << "Error: Could not save progress to: " << filename << std::endl;
+        return false;
+    }
+    Stats::add(StatCounter::BytesWritten, outFile.size());
+    return true;
+}
+
+// Hands every course to `addCourse` and restores the unnamed counter: straight from the header
+// when the file has one, otherwise by checking each name as it goes past. The header is decoded
+// into `header` before the first course is handed over. A missing file is an empty book; a file
+// that exists but can't be read, or a corrupt binary file, is reported and gives std::nullopt,
+// after handing over whatever courses came before the damage.
+template <typename CourseHandler>
+std::optional<CourseFileFormat> loadAll(const std::string& filename, int& unnamedCounter, CourseFileHeader& header,
+                         CourseHandler&& addCourse) {
+    const ScopedTimer timer(StatTimer::LoadCourses);
+    std::size_t rows = 0;
+    const auto add = [&](const CourseView& view) {
+        addCourse(view);
+        ++rows;
+        if (!header.present) {
+            updateUnnamedCounter(view.name, unnamedCounter);
+        }
+    };
+
+    const CourseFileFormat format = detectFormat(filename);
+    if (format == CourseFileFormat::Binary) {
+        if (!readBinary(filename, add, header)) {
+            return std::nullopt;
+        }
+    } else {
+        InputReport report;
+        if (!streamCourses(filename, add, report, &header)) {
+            std::error_code error;
+            if (std::filesystem::exists(filename, error) || error) {
+                std::cerr << "Error: Could not read data file: " << filename << std::endl;
+                return std::nullopt;
+            }
+        }
+        report.print(std::cerr, filename);
+        Stats::add(StatCounter::RowsRejected, report.rejected());
+    }
+    Stats::add(StatCounter::RowsParsed, rows);
+    if (header.present) {
+        unnamedCounter = std::max(unnamedCounter, header.unnamedCounter);
+    }
+    return format;
+}
+
+} // namespace
+
+std::size_t binaryHeaderSize(const std::uint32_t version) {
+    return version == 1 ? BINARY_V1_HEADER_SIZE : sizeof(BinaryHeader);
+}
+
+bool validBinaryHeader(const BinaryHeader& header, const std::size_t fileSize) {
+    if (std::memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0
+        || header.version < 1 || header.version > BINARY_VERSION) {
+        return false;
+    }
+    const std::size_t headerSize = binaryHeaderSize(header.version);
+    if (fileSize < headerSize) {
+        return false;
+    }
+    if (header.scheme >= SCHEME_COUNT) {
+        return false;
+    }
+    // Credits and grade columns, plus the term column from version 3.
+    const std::uint64_t columns = header.version >= 3 ? 3 : 2;
+    const std::uint64_t payload = fileSize - headerSize;
+    if (header.courseCount > payload / (sizeof(std::uint64_t) + columns) || header.namesSize > payload) {
+        return false;
+    }
+    return headerSize + (header.courseCount + 1) * sizeof(std::uint64_t)
+           + header.namesSize + columns * header.courseCount == fileSize;
+}
+
+bool readBinaryHeader(const char* data, const std::size_t fileSize, BinaryHeader& header) {
+    header = {};
+    if (fileSize < BINARY_V1_HEADER_SIZE) {
+        return false;
+    }
+    std::memcpy(&header, data, BINARY_V1_HEADER_SIZE);
+    if (header.version >= 2 && fileSize >= sizeof(BinaryHeader)) {
+        std::memcpy(&header, data, sizeof(BinaryHeader));
+    }
+    return validBinaryHeader(header, fileSize);
+}
+
+bool parseTextHeader(std::string_view line, CourseFileHeader& header) {
+    if (!line.starts_with(TEXT_HEADER_PREFIX)) {
+        return false;
+    }
+    line.remove_prefix(TEXT_HEADER_PREFIX.size());
+    if (!line.empty() && line.front() != ' ') {
+        return false;
+    }
+
+    header = {};
+    header.present = true;
+    while (!line.empty()) {
+        const auto space = line.find(' ');
+        const std::string_view field = line.substr(0, space);
+        line = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+
+        const auto equals = field.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        const std::string_view key = field.substr(0, equals);
+        if (key == "unnamed") {
+            parseNumber(field.substr(equals + 1), header.unnamedCounter);
+        } else if (key == "fields") {
+            int fields;
+            if (parseNumber(field.substr(equals + 1), fields) && fields >= 3) {
+                header.fields = fields;
+            }
+        } else if (key == "scheme") {
+            if (const auto scheme = parseScheme(field.substr(equals + 1))) {
+                header.scheme = *scheme;
+            }
+        }
+    }
+    return true;
+}
+
+void updateUnnamedCounter(const std::string_view name, int& unnamedCounter) {
+    constexpr std::string_view PREFIX = "Unnamed Course ";
+    if (!name.starts_with(PREFIX)) {
+        return;
+    }
+    // Like the std::stoi this replaces: leading digits count, anything after them is ignored.
+    const std::string_view digits = trim(name.substr(PREFIX.size()));
+    int number = 0;
+    const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), number);
+    if (error == std::errc() && number > unnamedCounter) {
+        unnamedCounter = number;
+    }
+}
+
+CourseFileFormat detectFormat(const std::string& filename) {
+    std::ifstream inFile(filename, std::ios::binary);
+    char magic[sizeof(BINARY_MAGIC)] = {};
+    inFile.read(magic, sizeof(magic));
+    if (inFile.gcount() == sizeof(magic) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+        return CourseFileFormat::Binary;
+    }
+    return CourseFileFormat::Text;
+}
+
+CourseFileFormat readFileHeader(const std::string& filename, CourseFileHeader& header) {
+    header = {};
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+    if (!inFile.is_open()) {
+        return CourseFileFormat::Text;
+    }
+    const auto fileSize = static_cast<std::size_t>(inFile.tellg());
+    char headerBytes[sizeof(BinaryHeader)] = {};
+    inFile.seekg(0);
+    inFile.read(headerBytes, sizeof(headerBytes));
+    if (inFile.gcount() >= static_cast<std::streamsize>(sizeof(BINARY_MAGIC))
+        && std::memcmp(headerBytes, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+        BinaryHeader binary;
+        if (readBinaryHeader(headerBytes, fileSize, binary)) {
+            header.present = binary.version >= 2;
+            header.unnamedCounter = static_cast<int>(std::min<std::uint32_t>(binary.unnamedCounter, INT32_MAX));
+            header.scheme = static_cast<GradingScheme>(binary.scheme);
+        }
+        return CourseFileFormat::Binary;
+    }
+
+    inFile.clear();
+    inFile.seekg(0);
+    std::string line;
+    std::getline(inFile, line);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    parseTextHeader(line, header);
+    return CourseFileFormat::Text;
+}
+
+bool saveCourses(const std::vector<Course>& courses, const std::string& filename, const CourseFileFormat format,
+                 const int unnamedCounter, const GradingScheme scheme) {
+    return saveAll(courses, filename, format, unnamedCounter, scheme);
+}
+
+bool saveCourses(const CourseBook& courses, const std::string& filename, const CourseFileFormat format,
+                 const int unnamedCounter) {
+    return saveAll(courses, filename, format, unnamedCounter, courses.scheme());
+}
+
+std::optional<CourseFileFormat> loadCourses(std::vector<Course>& courses, int& unnamedCounter,
+                                            const std::string& filename, GradingScheme* scheme) {
+    CourseFileHeader header;
+    const auto format = loadAll(filename, unnamedCounter, header, [&](const CourseView& view) {
+        courses.push_back({std::string(view.name), view.credits, view.grade, view.term});
+    });
+    if (scheme) {
+        *scheme = header.scheme;
+    }
+    return format;
+}
+
+std::optional<CourseFileFormat> loadCourses(CourseBook& courses, int& unnamedCounter, const std::string& filename) {
+    CourseFileHeader header;
+    // The book is switched to the file's scheme before its first course, while regrading is free.
+    bool first = true;
+    const auto format = loadAll(filename, unnamedCounter, header, [&](const CourseView& view) {
+        if (first) {
+            first = false;
+            courses.setScheme(header.scheme);
+        }
+        courses.add(view);
+    });
+    if (first) {
+        courses.setScheme(header.scheme);
+    }
+    return format;
+}
+
+bool summarizeCourses(const std::string& filename, GpaTotals& totals) {
+    if (detectFormat(filename) == CourseFileFormat::Text) {
+        LatestAttempts latest;
+        InputReport report;
+        CourseFileHeader header;
+        const bool opened = streamCourses(filename, [&](const CourseView& view) {
+            latest.add(view, header.scheme);
+        }, report, &header);
+        report.print(std::cerr, filename);
+        totals.add(latest.totals());
+        return opened;
+    }
+
+    // Mapped, so the courses are read in place and their names are borrowed from the mapping.
+    MappedCourses courses;
+    if (!courses.open(filename)) {
+        return false;
+    }
+    LatestAttempts latest(true);
+    for (const CourseView course : courses) {
+        latest.add(course, courses.scheme());
+    }
+    totals.add(latest.totals());
+    return true;
+}
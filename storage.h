@@ -0,0 +1,191 @@
+#ifndef GPA_CALC_STORAGE_H
+#define GPA_CALC_STORAGE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "course.h"
+#include "course_book.h"
+#include "text_reader.h"
+#include "validation.h"
+
+enum class CourseFileFormat {
+    Text,
+    Binary
+};
+
+// Binary data files start with this header, followed by (courseCount + 1) uint64 name offsets,
+// the concatenated names (namesSize bytes), one uint8 credits per course, one uint8 grade
+// code (the value of its Grade) per course and, from version 3, one uint8 term per course. All
+// integers are little-endian. Version 1 headers end after namesSize (32 bytes) and carry no
+// unnamed counter; files before version 3 have every course in term 1. The grading scheme sits in
+// what used to be a reserved field, so older files read as FCAI.
+struct BinaryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t courseCount;
+    std::uint64_t namesSize;
+    std::uint32_t unnamedCounter;
+    std::uint32_t scheme;
+};
+
+// The leading non-ASCII byte keeps the magic from ever matching the first line of a text file.
+inline constexpr char BINARY_MAGIC[8] = {'\x89', 'G', 'P', 'A', '\r', '\n', '\x1a', '\n'};
+inline constexpr std::uint32_t BINARY_VERSION = 3;
+inline constexpr std::size_t BINARY_V1_HEADER_SIZE = 32;
+
+// Text data files start with a line holding this prefix and space-separated key=value fields,
+// e.g. "#!gpa-calc unnamed=12 fields=4 scheme=us43". Files written before the header existed start
+// with a course name.
+inline constexpr std::string_view TEXT_HEADER_PREFIX = "#!gpa-calc";
+
+// Metadata stored in a data file's header, so it doesn't have to be rebuilt from the courses.
+struct CourseFileHeader {
+    bool present = false;
+    // Highest N of any "Unnamed Course N" the file's author has generated.
+    int unnamedCounter = 0;
+    // Lines per course record: name, credits and points, then the term if there are four.
+    // Lines past the fourth are skipped, so later versions can add fields.
+    int fields = 3;
+    // Scale the stored points (text) or grade codes (binary) are on; absent means FCAI.
+    GradingScheme scheme = GradingScheme::Fcai;
+};
+
+// Number of bytes the header of a binary file of this version occupies.
+std::size_t binaryHeaderSize(std::uint32_t version);
+// Checks the magic and version, and that the header describes a file of exactly `fileSize` bytes.
+bool validBinaryHeader(const BinaryHeader& header, std::size_t fileSize);
+// Decodes the header of either version from the first bytes of a binary file (at most
+// sizeof(BinaryHeader) of them are read) and validates it against the full file size;
+// version 1 headers read back with an unnamed counter of 0.
+bool readBinaryHeader(const char* data, std::size_t fileSize, BinaryHeader& header);
+// Parses a text header line; false if `line` isn't one. Unknown fields are ignored.
+bool parseTextHeader(std::string_view line, CourseFileHeader& header);
+
+// Detects the format from the file's first bytes. Missing and empty files count as text.
+CourseFileFormat detectFormat(const std::string& filename);
+// Detects the format and decodes the header without reading any courses. Missing files, and text
+// files without a header, leave `header` at its defaults.
+CourseFileFormat readFileHeader(const std::string& filename, CourseFileHeader& header);
+
+// Writes the file with a header recording `unnamedCounter` and the grading scheme (a CourseBook's
+// own). Returns false (after reporting the error) if the file couldn't be written; success is left
+// for the caller to report.
+bool saveCourses(const std::vector<Course>& courses, const std::string& filename,
+                 CourseFileFormat format = CourseFileFormat::Text, int unnamedCounter = 0,
+                 GradingScheme scheme = GradingScheme::Fcai);
+bool saveCourses(const CourseBook& courses, const std::string& filename,
+                 CourseFileFormat format = CourseFileFormat::Text, int unnamedCounter = 0);
+// Loads either format and returns the one the file was in, so it can be saved back the same way.
+// The unnamed counter comes from the file header; for files without one it is rebuilt from the names.
+// The file's grading scheme is returned through `scheme` if given. A missing file loads as empty.
+// A file that can't be read, or a truncated or corrupt binary file, is reported and gives
+// std::nullopt; the courses are then incomplete and must not be saved over the file.
+std::optional<CourseFileFormat> loadCourses(std::vector<Course>& courses, int& unnamedCounter,
+                                            const std::string& filename, GradingScheme* scheme = nullptr);
+// Loading into a CourseBook interns the names instead of allocating a string per course, and sets
+// the book's grading scheme to the file's.
+std::optional<CourseFileFormat> loadCourses(CourseBook& courses, int& unnamedCounter, const std::string& filename);
+
+// Raises the counter to N if `name` is an auto-generated "Unnamed Course N". Doesn't allocate.
+void updateUnnamedCounter(std::string_view name, int& unnamedCounter);
+
+// Sums a data file's credits and weighted points, on its grading scheme, without materialising
+// its courses. Like a CourseBook's cumulative(), a retaken course counts only by its latest attempt,
+// so only the distinct names are kept.
+bool summarizeCourses(const std::string& filename, GpaTotals& totals);
+
+// Checks one record of a text data file, whose lines are in `record`: name, credits, points and,
+// if `fields` is at least 4, term. A field that isn't a number at all wins over a bad value, since
+// it means the record is misaligned rather than wrong.
+template <typename Lines>
+InputIssue checkTextRecord(const Lines& record, const int fields, const GradingScheme scheme, CourseView& course) {
+    course.term = 1;
+    const std::array<InputError, 3> errors = {
+        checkCredits(record[1], course.credits),
+        checkPoints(record[2], scheme, course.grade),
+        fields >= 4 ? checkTerm(record[3], course.term) : InputError::None,
+    };
+    InputIssue issue;
+    for (std::size_t i = 0; i < errors.size(); ++i) {
+        if (errors[i] != InputError::None
+            && (issue.error == InputError::None || (breaksFraming(errors[i]) && !breaksFraming(issue.error)))) {
+            issue = {errors[i], 0, i + 2};
+        }
+    }
+    course.name = record[0];
+    return issue;
+}
+
+// Streams the records (name, credits, points and, if the header says so, term) of a text data
+// file into the handler as CourseViews that are only valid during the call. A record with a bad
+// value is dropped as a whole. A record with a field that isn't a number at all has probably lost
+// or gained a line, so the reader slides forward a line at a time until the record framing lines
+// up again, instead of misreading every record after it. Every rejected record, and every such
+// resynchronization, is added to `report`. Returns false if the file can't be opened. A header
+// line is skipped and, if `header` is given, decoded into it. The lines of one record are kept in
+// reused strings, so no allocation happens per record.
+template <typename CourseHandler>
+bool streamCourses(const std::string& filename, CourseHandler&& handler, InputReport& report,
+                   CourseFileHeader* header = nullptr) {
+    std::vector<std::string> record(3);
+    std::size_t filled = 0;
+    std::size_t lineNumber = 0;
+    bool resyncing = false;
+    int fields = 3;
+    GradingScheme scheme = GradingScheme::Fcai;
+
+    const bool opened = forEachLine(filename, [&](std::string_view line) {
+        if (++lineNumber == 1) {
+            CourseFileHeader decoded;
+            if (parseTextHeader(line, decoded)) {
+                fields = decoded.fields;
+                scheme = decoded.scheme;
+                record.resize(fields);
+                if (header) {
+                    *header = decoded;
+                }
+                return;
+            }
+        }
+        record[filled++].assign(line);
+        if (filled < record.size()) {
+            return;
+        }
+
+        CourseView course{};
+        InputIssue issue = checkTextRecord(record, fields, scheme, course);
+        if (issue.error == InputError::None) {
+            handler(course);
+            filled = 0;
+            resyncing = false;
+            return;
+        }
+        issue.line = lineNumber - record.size() + 1;
+        if (!resyncing) {
+            report.add(issue);
+        }
+        if (resyncing || breaksFraming(issue.error)) {
+            // Drop the first line and try again once the next one arrives.
+            std::rotate(record.begin(), record.begin() + 1, record.end());
+            --filled;
+            resyncing = true;
+        } else {
+            filled = 0;
+        }
+    });
+    // A trailing record without all its lines is incomplete.
+    if (filled > 0 && !resyncing) {
+        report.add({InputError::MissingField, lineNumber - filled + 1, filled + 1});
+    }
+    return opened;
+}
+
+#endif //GPA_CALC_STORAGE_H
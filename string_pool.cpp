@@ -0,0 +1,98 @@
+#include "string_pool.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+StringPool::Id StringPool::intern(const std::string_view text, const bool borrow) {
+    if (buckets_.size() < 2 * (strings_.size() + 1)) {
+        rehash(buckets_.empty() ? 64 : 2 * buckets_.size());
+    }
+    const std::size_t hash = std::hash<std::string_view>{}(text);
+    const std::size_t bucket = bucketOf(text, hash);
+    if (buckets_[bucket] != EMPTY_BUCKET) {
+        return buckets_[bucket];
+    }
+    if (strings_.size() == EMPTY_BUCKET) {
+        throw std::length_error("StringPool: too many distinct strings");
+    }
+
+    const auto id = static_cast<Id>(strings_.size());
+    strings_.push_back(borrow ? text : store(text));
+    hashes_.push_back(hash);
+    buckets_[bucket] = id;
+    return id;
+}
+
+std::optional<StringPool::Id> StringPool::find(const std::string_view text) const {
+    if (buckets_.empty()) {
+        return std::nullopt;
+    }
+    const Id id = buckets_[bucketOf(text, std::hash<std::string_view>{}(text))];
+    if (id == EMPTY_BUCKET) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::size_t StringPool::memoryUsage() const {
+    return blockBytes_ + strings_.capacity() * sizeof(std::string_view)
+           + hashes_.capacity() * sizeof(std::size_t) + buckets_.capacity() * sizeof(Id);
+}
+
+void StringPool::clear() {
+    blocks_.clear();
+    blockBytes_ = 0;
+    cursor_ = nullptr;
+    remaining_ = 0;
+    strings_.clear();
+    hashes_.clear();
+    buckets_.clear();
+}
+
+std::string_view StringPool::store(const std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    // Long strings get a block of their own so they don't waste the rest of the current one.
+    if (text.size() > BLOCK_SIZE / 4) {
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(text.size()));
+        blockBytes_ += text.size();
+        std::memcpy(blocks_.back().get(), text.data(), text.size());
+        return {blocks_.back().get(), text.size()};
+    }
+    if (remaining_ < text.size()) {
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(BLOCK_SIZE));
+        blockBytes_ += BLOCK_SIZE;
+        cursor_ = blocks_.back().get();
+        remaining_ = BLOCK_SIZE;
+    }
+    std::memcpy(cursor_, text.data(), text.size());
+    const std::string_view stored(cursor_, text.size());
+    cursor_ += text.size();
+    remaining_ -= text.size();
+    return stored;
+}
+
+void StringPool::rehash(const std::size_t buckets) {
+    buckets_.assign(buckets, EMPTY_BUCKET);
+    const std::size_t mask = buckets - 1;
+    for (Id id = 0; id < strings_.size(); ++id) {
+        std::size_t bucket = hashes_[id] & mask;
+        while (buckets_[bucket] != EMPTY_BUCKET) {
+            bucket = (bucket + 1) & mask;
+        }
+        buckets_[bucket] = id;
+    }
+}
+
+// The bucket holding `text`, or the empty bucket where it would be inserted.
+std::size_t StringPool::bucketOf(const std::string_view text, const std::size_t hash) const {
+    const std::size_t mask = buckets_.size() - 1;
+    std::size_t bucket = hash & mask;
+    while (buckets_[bucket] != EMPTY_BUCKET
+           && (hashes_[buckets_[bucket]] != hash || strings_[buckets_[bucket]] != text)) {
+        bucket = (bucket + 1) & mask;
+    }
+    return bucket;
+}
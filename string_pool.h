@@ -0,0 +1,57 @@
+#ifndef GPA_CALC_STRING_POOL_H
+#define GPA_CALC_STRING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Interns strings into an append-only arena and hands out dense 32-bit IDs for them. Equal strings
+// share one copy, so a data set with millions of rows but a few hundred distinct course names
+// stores each name once, and every string costs one bump of the arena cursor instead of a heap
+// allocation. Views returned by operator[] stay valid until the pool is cleared or destroyed
+// (moving the pool keeps them valid too).
+class StringPool {
+public:
+    using Id = std::uint32_t;
+
+    StringPool() = default;
+    StringPool(StringPool&&) noexcept = default;
+    StringPool& operator=(StringPool&&) noexcept = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Returns the ID of `text`, copying it into the arena the first time it is seen. With `borrow`,
+    // the pool keeps the view itself instead, so the text must outlive the pool.
+    Id intern(std::string_view text, bool borrow = false);
+    // Returns the ID of `text` if it has been interned, without adding it.
+    std::optional<Id> find(std::string_view text) const;
+
+    std::string_view operator[](Id id) const { return strings_[id]; }
+    std::size_t size() const { return strings_.size(); }
+    // Bytes reserved by the arena and the lookup table.
+    std::size_t memoryUsage() const;
+    void clear();
+
+    static constexpr std::size_t BLOCK_SIZE = 64 << 10;
+
+private:
+    std::string_view store(std::string_view text);
+    void rehash(std::size_t buckets);
+    std::size_t bucketOf(std::string_view text, std::size_t hash) const;
+
+    static constexpr Id EMPTY_BUCKET = UINT32_MAX;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t blockBytes_ = 0;
+    char* cursor_ = nullptr;
+    std::size_t remaining_ = 0;
+    std::vector<std::string_view> strings_;
+    std::vector<std::size_t> hashes_;
+    // Open-addressing table of IDs, linear probing, always a power of two at most half full.
+    std::vector<Id> buckets_;
+};
+
+#endif //GPA_CALC_STRING_POOL_H
@@ -0,0 +1,100 @@
+#ifndef GPA_CALC_TERM_TOTALS_H
+#define GPA_CALC_TERM_TOTALS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "course.h"
+#include "string_pool.h"
+
+// Running totals of a multi-term transcript: the courses taken in each term, and the cumulative
+// totals after each term. What a term contributes to the cumulative totals is kept as a delta
+// (its courses, minus the earlier attempts its retakes replace), and the deltas sit in a Fenwick
+// tree, so changing a course touches O(log MAX_TERM) nodes instead of every later term, and any
+// cumulative total is an O(log MAX_TERM) prefix sum. The caller works out the deltas.
+class TermTotals {
+public:
+    void addCourse(const int term, const int credits, const Grade grade, const GradingScheme scheme) {
+        taken_[term].add(credits, grade, scheme);
+        ++courses_[term];
+    }
+    void removeCourse(const int term, const int credits, const Grade grade, const GradingScheme scheme) {
+        taken_[term].add(-credits, grade, scheme);
+        --courses_[term];
+    }
+    // Adds already weighted totals to the cumulative totals of `term` and every later term
+    // (negative credits and points take them away again).
+    void addCumulative(const int term, const GpaTotals& change) {
+        for (int node = term; node <= MAX_TERM; node += node & -node) {
+            cumulative_[node].add(change);
+        }
+    }
+
+    // Every course taken in `term`, retaken or not.
+    const GpaTotals& term(const int term) const { return taken_[term]; }
+    std::uint32_t courses(const int term) const { return courses_[term]; }
+    // The transcript as of the end of `term`: each course counted once, by its latest attempt.
+    GpaTotals cumulative(const int term) const {
+        GpaTotals totals;
+        for (int node = term; node > 0; node -= node & -node) {
+            totals.add(cumulative_[node]);
+        }
+        return totals;
+    }
+    // Highest term that has a course, or 0 for an empty transcript.
+    int lastTerm() const {
+        int term = MAX_TERM;
+        while (term > 0 && courses_[term] == 0) {
+            --term;
+        }
+        return term;
+    }
+
+private:
+    std::array<GpaTotals, MAX_TERM + 1> taken_ {};
+    std::array<std::uint32_t, MAX_TERM + 1> courses_ {};
+    // Fenwick tree over terms 1..MAX_TERM of the per-term cumulative deltas.
+    std::array<GpaTotals, MAX_TERM + 1> cumulative_ {};
+};
+
+// Cumulative totals of courses seen one at a time, e.g. straight from a file, in which a course
+// taken more than once counts only by its latest attempt (highest term, then latest seen), like a
+// CourseBook's cumulative(). Names are interned, so memory grows with the distinct names, not
+// with the courses. With `borrowNames`, names are not copied either, so the courses' names must
+// outlive this object (as those of a MappedCourses do).
+class LatestAttempts {
+public:
+    explicit LatestAttempts(const bool borrowNames = false) : borrowNames_(borrowNames) {}
+
+    void add(const CourseView& course, const GradingScheme scheme) {
+        const StringPool::Id name = names_.intern(course.name, borrowNames_);
+        if (name == latest_.size()) {
+            latest_.push_back({course.credits, course.grade, course.term});
+        } else {
+            Attempt& previous = latest_[name];
+            if (course.term < previous.term) {
+                return;
+            }
+            totals_.add(-previous.credits, previous.grade, scheme);
+            previous = {course.credits, course.grade, course.term};
+        }
+        totals_.add(course.credits, course.grade, scheme);
+    }
+
+    const GpaTotals& totals() const { return totals_; }
+
+private:
+    struct Attempt {
+        int credits;
+        Grade grade;
+        int term;
+    };
+
+    bool borrowNames_;
+    StringPool names_;
+    std::vector<Attempt> latest_;
+    GpaTotals totals_;
+};
+
+#endif //GPA_CALC_TERM_TOTALS_H
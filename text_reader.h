@@ -0,0 +1,78 @@
+#ifndef GPA_CALC_TEXT_READER_H
+#define GPA_CALC_TEXT_READER_H
+
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stats.h"
+
+inline constexpr std::size_t IO_BUFFER_SIZE = 1 << 20;
+
+inline std::string_view trim(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) value.remove_prefix(1);
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.remove_suffix(1);
+    return value;
+}
+
+// Parses the whole (trimmed) field as a number without throwing; trailing junk is a failure.
+template <typename Number>
+bool parseNumber(std::string_view field, Number& value) {
+    field = trim(field);
+    const auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && end == field.data() + field.size() && !field.empty();
+}
+
+// Splits off the next tab-separated field of a journal record or server request.
+inline std::string_view nextField(std::string_view& rest) {
+    const auto tab = rest.find('\t');
+    const std::string_view field = rest.substr(0, tab);
+    rest = tab == std::string_view::npos ? std::string_view() : rest.substr(tab + 1);
+    return field;
+}
+
+// Reads the file in large blocks and hands every line, without its "\n" or "\r\n" terminator,
+// to the handler. Lines are only valid during the call. Memory stays at one block (plus the
+// longest line) no matter how large the file is. Returns false if the file can't be opened.
+template <typename LineHandler>
+bool forEachLine(const std::string& filename, LineHandler&& handler) {
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile.is_open()) {
+        return false;
+    }
+
+    std::vector<char> buffer(IO_BUFFER_SIZE);
+    std::size_t pending = 0;
+    while (inFile) {
+        if (pending == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        inFile.read(buffer.data() + pending, static_cast<std::streamsize>(buffer.size() - pending));
+        const std::size_t filled = pending + static_cast<std::size_t>(inFile.gcount());
+        Stats::add(StatCounter::BytesRead, static_cast<std::uint64_t>(inFile.gcount()));
+
+        const char* cursor = buffer.data();
+        const char* end = buffer.data() + filled;
+        while (const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor))) {
+            std::string_view line(cursor, newline - cursor);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            handler(line);
+            cursor = newline + 1;
+        }
+        pending = end - cursor;
+        std::memmove(buffer.data(), cursor, pending);
+    }
+    if (pending > 0) {
+        std::string_view line(buffer.data(), pending);
+        if (line.back() == '\r') line.remove_suffix(1);
+        handler(line);
+    }
+    return true;
+}
+
+#endif //GPA_CALC_TEXT_READER_H
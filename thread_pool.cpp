@@ -0,0 +1,107 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Index of the pool worker running on this thread, or -1 outside any pool.
+thread_local int currentWorker = -1;
+thread_local const ThreadPool* currentPool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard lock(stateMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    const unsigned index = currentPool == this ? static_cast<unsigned>(currentWorker)
+                                               : nextQueue_.fetch_add(1, std::memory_order_relaxed) % size();
+    {
+        // Counted before the push, since another worker may steal and finish the task right away.
+        // The only place both locks are held, always in this order.
+        std::lock_guard state(stateMutex_);
+        ++queued_;
+        ++unfinished_;
+        std::lock_guard lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(stateMutex_);
+    allDone_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool ThreadPool::takeTask(const unsigned index, std::function<void()>& task) {
+    {
+        TaskQueue& own = *queues_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned offset = 1; offset < size(); ++offset) {
+        TaskQueue& victim = *queues_[(index + offset) % size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(const unsigned index) {
+    currentWorker = static_cast<int>(index);
+    currentPool = this;
+
+    std::function<void()> task;
+    while (true) {
+        if (takeTask(index, task)) {
+            {
+                std::lock_guard lock(stateMutex_);
+                --queued_;
+            }
+            task();
+            task = nullptr;
+
+            std::lock_guard lock(stateMutex_);
+            if (--unfinished_ == 0) {
+                allDone_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock(stateMutex_);
+        workAvailable_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef GPA_CALC_THREAD_POOL_H
+#define GPA_CALC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with one task deque per worker. Workers run their own tasks
+// newest-first and, once their deque is empty, steal the oldest task of another worker, so
+// uneven tasks still keep every core busy. Tasks must not throw.
+class ThreadPool {
+public:
+    // Zero threads means one per hardware thread.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues a task on the calling worker's deque, or round-robin when called from outside the pool.
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool takeTask(unsigned index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<unsigned> nextQueue_{0};
+
+    std::mutex stateMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+    std::size_t queued_ = 0;
+    std::size_t unfinished_ = 0;
+    bool stopping_ = false;
+};
+
+#endif //GPA_CALC_THREAD_POOL_H
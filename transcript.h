@@ -0,0 +1,64 @@
+#ifndef GPA_CALC_TRANSCRIPT_H
+#define GPA_CALC_TRANSCRIPT_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "course.h"
+
+// Listings are formatted into one buffer and written with a single call once it holds this
+// much, so short listings cost one write and long ones start appearing right away.
+inline constexpr std::size_t TRANSCRIPT_FLUSH_SIZE = 256 << 10;
+inline constexpr std::string_view TRANSCRIPT_SEPARATOR = "----------------------------------------\n";
+
+// Appends one numbered transcript entry without allocating (once the buffer has grown).
+template <typename CourseLike>
+void appendCourse(std::string& buffer, const std::size_t number, const CourseLike& course) {
+    char digits[24];
+    buffer += TRANSCRIPT_SEPARATOR;
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr);
+    buffer += ".\n   Course Name:   ";
+    buffer += course.name;
+    buffer += "\n   Course Credits: ";
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), course.credits).ptr);
+    buffer += "\n   Course Grade:   ";
+    buffer += gradeLetter(course.grade);
+    buffer += "\n   Course Term:    ";
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), course.term).ptr);
+    buffer += '\n';
+}
+
+// Lists courses [first, first + count) as a numbered transcript. Works with any container of
+// Course or CourseView that has size() and operator[]. Rendering reuses one per-thread buffer.
+template <typename Courses>
+void viewCourses(const Courses& courses, const std::size_t first = 0,
+                 const std::size_t count = std::numeric_limits<std::size_t>::max(), std::ostream& out = std::cout) {
+    if (courses.empty()) {
+        out << "No courses to display.\n";
+        return;
+    }
+
+    thread_local std::string buffer;
+    buffer.clear();
+    buffer.reserve(TRANSCRIPT_FLUSH_SIZE + 512);
+
+    const std::size_t last = first + std::min(count, courses.size() - std::min(first, courses.size()));
+    for (std::size_t i = first; i < last; ++i) {
+        appendCourse(buffer, i + 1, courses[i]);
+        if (buffer.size() >= TRANSCRIPT_FLUSH_SIZE) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            out.flush();
+            buffer.clear();
+        }
+    }
+    buffer += TRANSCRIPT_SEPARATOR;
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+}
+
+#endif //GPA_CALC_TRANSCRIPT_H
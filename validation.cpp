@@ -0,0 +1,40 @@
+#include "validation.h"
+
+#include <algorithm>
+
+void InputReport::merge(const InputReport& later, const std::size_t lineOffset) {
+    for (std::size_t i = 0; i < std::min(later.rejected_, MAX_DETAILED) && rejected_ + i < MAX_DETAILED; ++i) {
+        detailed_[rejected_ + i] = later.detailed_[i];
+        detailed_[rejected_ + i].line += lineOffset;
+    }
+    for (int error = 0; error < INPUT_ERROR_COUNT; ++error) {
+        counts_[error] += later.counts_[error];
+    }
+    rejected_ += later.rejected_;
+}
+
+void InputReport::print(std::ostream& out, const std::string_view source) const {
+    if (rejected_ == 0) {
+        return;
+    }
+    out << "Warning: Skipped " << rejected_ << " malformed record(s) in " << source << ":\n";
+    for (std::size_t i = 0; i < std::min(rejected_, MAX_DETAILED); ++i) {
+        const InputIssue& issue = detailed_[i];
+        out << "  line " << issue.line;
+        if (issue.column > 0) {
+            out << ", column " << issue.column;
+        }
+        out << ": " << describe(issue.error) << "\n";
+    }
+    if (rejected_ > MAX_DETAILED) {
+        out << "  ... " << rejected_ - MAX_DETAILED << " more. In total:";
+        const char* separator = " ";
+        for (int error = 0; error < INPUT_ERROR_COUNT; ++error) {
+            if (counts_[error] > 0) {
+                out << separator << counts_[error] << " x " << describe(static_cast<InputError>(error));
+                separator = "; ";
+            }
+        }
+        out << "\n";
+    }
+}
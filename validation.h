@@ -0,0 +1,153 @@
+#ifndef GPA_CALC_VALIDATION_H
+#define GPA_CALC_VALIDATION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#include "course.h"
+#include "text_reader.h"
+
+// Field checks shared by every input path: the menu, data files, the journal, CSV imports, rosters
+// and the server. They never throw or allocate, and return what was wrong instead of a bool, so
+// callers can report it with the line and column it came from.
+enum class InputError : std::uint8_t {
+    None,
+    MissingField,
+    NotANumber,
+    CreditsOutOfRange,
+    UnknownGrade,
+    GradeOffScale,
+    PointsNotOnScale,
+    TermOutOfRange,
+    EmptyField,
+    LineBreakInName,
+    BadQuoting
+};
+
+inline constexpr int INPUT_ERROR_COUNT = static_cast<int>(InputError::BadQuoting) + 1;
+
+static_assert(MAX_CREDITS == 9 && MAX_TERM == 99, "update the ranges in describe()");
+
+constexpr std::string_view describe(const InputError error) {
+    switch (error) {
+        case InputError::None: return "valid";
+        case InputError::MissingField: return "record is missing fields";
+        case InputError::NotANumber: return "not a number";
+        case InputError::CreditsOutOfRange: return "credits must be a number from 0 to 9";
+        case InputError::UnknownGrade: return "invalid grade";
+        case InputError::GradeOffScale: return "grade is not on the grading scale";
+        case InputError::PointsNotOnScale: return "points are not a grade on the grading scale";
+        case InputError::TermOutOfRange: return "term must be a number from 1 to 99";
+        case InputError::EmptyField: return "empty field";
+        case InputError::LineBreakInName: return "name spans several lines";
+        case InputError::BadQuoting: return "unclosed or misplaced quote";
+    }
+    return "invalid";
+}
+
+// Errors that suggest a record's fields aren't where they belong, e.g. because a line went missing,
+// as opposed to a well-placed field with a bad value. Line-framed readers resynchronize after them.
+constexpr bool breaksFraming(const InputError error) {
+    return error == InputError::NotANumber || error == InputError::MissingField;
+}
+
+// A rejected record: what was wrong, the 1-based line it starts on and the 1-based field (column)
+// that failed, or 0 if the record as a whole is at fault.
+struct InputIssue {
+    InputError error = InputError::None;
+    std::size_t line = 0;
+    std::size_t column = 0;
+};
+
+inline InputError checkCredits(const std::string_view field, int& credits) {
+    if (!parseNumber(field, credits)) return InputError::NotANumber;
+    return validCredits(credits) ? InputError::None : InputError::CreditsOutOfRange;
+}
+
+inline InputError checkTerm(const std::string_view field, int& term) {
+    if (!parseNumber(field, term)) return InputError::NotANumber;
+    return validTerm(term) ? InputError::None : InputError::TermOutOfRange;
+}
+
+template <GradingScheme Scheme>
+InputError checkGrade(const std::string_view field, Grade& grade) {
+    const auto parsed = parseGrade(trim(field));
+    if (!parsed) return InputError::UnknownGrade;
+    if (gradeTenths<Scheme>(*parsed) == OFF_SCALE) return InputError::GradeOffScale;
+    grade = *parsed;
+    return InputError::None;
+}
+
+inline InputError checkGrade(const std::string_view field, const GradingScheme scheme, Grade& grade) {
+    const auto parsed = parseGrade(trim(field));
+    if (!parsed) return InputError::UnknownGrade;
+    if (!onScale(*parsed, scheme)) return InputError::GradeOffScale;
+    grade = *parsed;
+    return InputError::None;
+}
+
+// Grade points as stored in text data files.
+inline InputError checkPoints(const std::string_view field, const GradingScheme scheme, Grade& grade) {
+    double points;
+    if (!parseNumber(field, points)) return InputError::NotANumber;
+    const auto parsed = gradeFromPoints(points, scheme);
+    if (!parsed) return InputError::PointsNotOnScale;
+    grade = *parsed;
+    return InputError::None;
+}
+
+// Parses the tab-separated "<term>\t<credits>\t<grade>\t<name>" of journal records and server
+// requests, or "<credits>\t<grade>\t<name>" for a course in term 1 if `withTerm` is false. Fields
+// are checked like the menu checks them, and the grade must be on the scheme's scale. The name is
+// the rest of the line. A failure names its 1-based field as the column.
+inline InputIssue parseCourseFields(std::string_view fields, const bool withTerm, const GradingScheme scheme,
+                                    CourseView& course) {
+    course.term = 1;
+    const std::size_t termColumns = withTerm ? 1 : 0;
+    if (const InputError error = withTerm ? checkTerm(nextField(fields), course.term) : InputError::None;
+        error != InputError::None) {
+        return {error, 0, 1};
+    }
+    if (const InputError error = checkCredits(nextField(fields), course.credits); error != InputError::None) {
+        return {error, 0, termColumns + 1};
+    }
+    if (const InputError error = checkGrade(nextField(fields), scheme, course.grade); error != InputError::None) {
+        return {error, 0, termColumns + 2};
+    }
+    course.name = fields;
+    return {};
+}
+
+// Tally of the records an input rejected: how many of each error, and the first few issues in
+// full. Its size is fixed, so recording an issue never allocates however dirty the input is.
+class InputReport {
+public:
+    static constexpr std::size_t MAX_DETAILED = 10;
+
+    void add(const InputIssue& issue) {
+        if (rejected_ < MAX_DETAILED) {
+            detailed_[rejected_] = issue;
+        }
+        ++counts_[static_cast<std::size_t>(issue.error)];
+        ++rejected_;
+    }
+    std::size_t rejected() const { return rejected_; }
+    std::size_t count(const InputError error) const { return counts_[static_cast<std::size_t>(error)]; }
+    // Appends the issues of a report on a later part of the same input, whose line numbers are
+    // relative to it and get `lineOffset` added, e.g. a chunk parsed on another thread.
+    void merge(const InputReport& later, std::size_t lineOffset);
+
+    // Writes a warning naming `source`, one line per detailed issue and, if there were more, the
+    // totals per error. Writes nothing if no record was rejected.
+    void print(std::ostream& out, std::string_view source) const;
+
+private:
+    std::array<InputIssue, MAX_DETAILED> detailed_ {};
+    std::array<std::size_t, INPUT_ERROR_COUNT> counts_ {};
+    std::size_t rejected_ = 0;
+};
+
+#endif //GPA_CALC_VALIDATION_H